@@ -2,7 +2,8 @@
 out vec4 FragColor;
 
 in vec3 Normal;
+in vec4 Color;
 
 void main(){
-	FragColor = vec4(abs(Normal),1.0);
-}
\ No newline at end of file
+	FragColor = vec4(abs(Normal),1.0) * Color;
+}
@@ -3,10 +3,23 @@ layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 
 out vec3 Normal;
-uniform mat4 _Model;
+out vec4 Color;
 
+#ifdef INSTANCED
+layout(location = 3) in mat4 vInstanceModel;
+layout(location = 7) in vec4 vInstanceColor;
+uniform mat4 _ViewProjection;
+#else
+uniform mat4 _Model;
+#endif
 
 void main(){
 	Normal = vNormal;
+#ifdef INSTANCED
+	Color = vInstanceColor;
+	gl_Position = _ViewProjection * vInstanceModel * vec4(vPos,1.0);
+#else
+	Color = vec4(1.0);
 	gl_Position = _Model * vec4(vPos,1.0);
-}
\ No newline at end of file
+#endif
+}
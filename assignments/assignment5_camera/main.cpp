@@ -12,14 +12,21 @@
 #include <ew/shader.h>
 #include <ew/procGen.h>
 #include <ew/transform.h>
+#include <ew/transformBatch.h>
+#include <ew/instanceBuffer.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
 int SCREEN_WIDTH = 1080;
 int SCREEN_HEIGHT = 720;
 
-const int NUM_CUBES = 4;
-ew::Transform cubeTransforms[NUM_CUBES];
+const int MAX_CUBES = 100000;
+int numCubes = 4;
+ew::Transform cubeTransforms[MAX_CUBES];
+ew::TransformStream cubeTransformStream;
+ew::Mat4 cubeModelMatrices[MAX_CUBES];
+ew::InstanceData cubeInstances[MAX_CUBES];
+bool drawInstanced = true;
 
 ml::Camera camera;
 ml::CameraControls cameraControls;
@@ -151,16 +158,27 @@ int main() {
 	glEnable(GL_DEPTH_TEST);
 
 	ew::Shader shader("assets/vertexShader.vert", "assets/fragmentShader.frag");
+	//Same shader reading the model matrix from per instance attributes
+	ew::Shader instancedShader("assets/vertexShader.vert", "assets/fragmentShader.frag", { "INSTANCED" });
+	ew::UniformHandle viewProjectionUniform = instancedShader.getUniform("_ViewProjection");
+	ew::InstanceBuffer cubeInstanceBuffer(numCubes);
 
 	//Cube mesh
 	ew::Mesh cubeMesh(ew::createCube(0.5f));
 
-	//Cube positions
-	for (size_t i = 0; i < NUM_CUBES; i++)
-	{
-		cubeTransforms[i].position.x = i % (NUM_CUBES / 2) - 0.5;
-		cubeTransforms[i].position.y = i / (NUM_CUBES / 2) - 0.5;
-	}
+	//Cube positions, in a square grid centered on the origin
+	auto layoutCubes = [&]() {
+		int gridSize = (int)ceilf(sqrtf((float)numCubes));
+		for (int i = 0; i < numCubes; i++)
+		{
+			cubeTransforms[i] = ew::Transform();
+			cubeTransforms[i].position.x = i % gridSize - (gridSize - 1) * 0.5f;
+			cubeTransforms[i].position.y = i / gridSize - (gridSize - 1) * 0.5f;
+		}
+	};
+	layoutCubes();
+	int drawCalls = 0;
+	float cpuFrameTime = 0.0f;
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
@@ -176,15 +194,34 @@ int main() {
 		//Clear both color buffer AND depth buffer
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		//Set uniforms
-		shader.use();
-
-		for (size_t i = 0; i < NUM_CUBES; i++)
-		{
-			//Construct model matrix
-			shader.setMat4("_Model", camera.ProjectionMatrix() * camera.ViewMatrix() * cubeTransforms[i].getModelMatrix());
-			cubeMesh.draw();
+		double renderStart = glfwGetTime();
+
+		//Construct all model matrices in one pass
+		cubeTransformStream.load(cubeTransforms, numCubes);
+		ew::computeModelMatrices(cubeTransformStream, cubeModelMatrices);
+		ew::Mat4 viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+
+		if (drawInstanced) {
+			//Every cube in one draw call
+			for (int i = 0; i < numCubes; i++)
+				cubeInstances[i].model = cubeModelMatrices[i];
+			cubeInstanceBuffer.upload(cubeInstances, numCubes);
+			instancedShader.use();
+			instancedShader.setMat4(viewProjectionUniform, viewProjection);
+			cubeMesh.drawInstanced(cubeInstanceBuffer);
+			drawCalls = 1;
+		}
+		else {
+			shader.use();
+			for (int i = 0; i < numCubes; i++)
+			{
+				shader.setMat4("_Model", viewProjection * cubeModelMatrices[i]);
+				cubeMesh.draw();
+			}
+			drawCalls = numCubes;
 		}
+		//Time to submit the frame, the GPU may still be working on it
+		cpuFrameTime = (float)(glfwGetTime() - renderStart) * 1000.0f;
 
 		// Render UI
 		{
@@ -197,7 +234,13 @@ int main() {
 
 			// Cubes Section
 			ImGui::Text("Cubes");
-			for (size_t i = 0; i < NUM_CUBES; i++) {
+			if (ImGui::SliderInt("Count", &numCubes, 1, MAX_CUBES))
+				layoutCubes();
+			ImGui::Checkbox("Instanced", &drawInstanced);
+			ImGui::Text("Draw calls: %i, CPU render time: %.3f ms", drawCalls, cpuFrameTime);
+			ImGui::Text("Instance buffer fence waits: %i", cubeInstanceBuffer.getNumFenceWaits());
+			//Only the first few cubes are editable, a header per cube doesn't scale
+			for (int i = 0; i < numCubes && i < 8; i++) {
 				ImGui::PushID(i);
 				if (ImGui::CollapsingHeader(("Cube " + std::to_string(i)).c_str())) {
 					ImGui::DragFloat3("Position##Cube", &cubeTransforms[i].position.x, 0.05f);
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_ARB_shader_draw_parameters : require
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
@@ -6,11 +7,14 @@ layout(location = 2) in vec2 vUV;
 out vec3 Normal;
 out vec2 UV;
 
-uniform mat4 _Model;
+//One model matrix per draw of a DrawBatch
+layout(std430) readonly buffer DrawBlock {
+	mat4 _Models[];
+};
 uniform mat4 _ViewProjection;
 
 void main(){
 	Normal = vNormal;
 	UV = vUV;
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
-}
\ No newline at end of file
+	gl_Position = _ViewProjection * _Models[gl_DrawIDARB] * vec4(vPos,1.0);
+}
@@ -11,6 +11,8 @@
 #include <ew/shader.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
+#include <ew/geometryArena.h>
+#include <ew/drawBatch.h>
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
@@ -84,30 +86,48 @@ int main() {
 	ew::Shader shader("assets/vertexShader.vert", "assets/fragmentShader.frag");
 	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg", GL_REPEAT, GL_LINEAR);
 
+	//Every shape shares one vertex buffer, index buffer and VAO. The arena grows if these capacities run out.
+	ew::GeometryArena geometryArena(4096, 16384);
+
 	//Create cube
 	ew::MeshData cubeMeshData = ew::createCube(0.75f);
-	ew::Mesh cubeMesh(cubeMeshData);
+	ew::MeshHandle cubeMesh = geometryArena.add(cubeMeshData);
 
 	//Initialize transforms
-	ew::Transform cubeTransform;
+	ew::CachedTransform cubeTransform;
 
 	//Plane
 	ew::MeshData planeMeshData = MyLib::createPlane(0.5f, 16);
-	ew::Mesh planeMesh(planeMeshData);
-	ew::Transform planeTransform;
-	planeTransform.position = ew::Vec3(1.0f, -0.5f, 0.0f);
+	ew::MeshHandle planeMesh = geometryArena.add(planeMeshData);
+	ew::CachedTransform planeTransform;
+	planeTransform.setPosition(ew::Vec3(1.0f, -0.5f, 0.0f));
 
 	// Create Cylinder
 	ew::MeshData cylinderMeshData = MyLib::createCylinder(1.0f, .5f, 16);
-	ew::Mesh cylinderMesh(cylinderMeshData);
-	ew::Transform cylinderTransform;
-	cylinderTransform.position = ew::Vec3(2.5f, 0.0f, 0.0f);
+	ew::MeshHandle cylinderMesh = geometryArena.add(cylinderMeshData);
+	ew::CachedTransform cylinderTransform;
+	cylinderTransform.setPosition(ew::Vec3(2.5f, 0.0f, 0.0f));
 
 	// Create sphere
 	ew::MeshData sphereMeshData = MyLib::createSphere(0.5f, 16);
-	ew::Mesh sphereMesh(sphereMeshData);
-	ew::Transform sphereTransform;
-	sphereTransform.position = ew::Vec3(4.0f, 0.0f, 0.0f);
+	ew::MeshHandle sphereMesh = geometryArena.add(sphereMeshData);
+	ew::CachedTransform sphereTransform;
+	sphereTransform.setPosition(ew::Vec3(4.0f, 0.0f, 0.0f));
+
+	//All four shapes share a material, so they are one multi-draw. Model matrices are indexed by gl_DrawIDARB.
+	//The batch is uploaded once here, and again only when a shape's transform version changes.
+	shader.bindStorageBlock("DrawBlock", ew::STORAGE_BINDING_DRAWS);
+	const int SHAPE_COUNT = 4;
+	const ew::CachedTransform* shapeTransforms[SHAPE_COUNT] = { &cubeTransform, &planeTransform, &cylinderTransform, &sphereTransform };
+	unsigned int shapeModelVersions[SHAPE_COUNT];
+	ew::DrawBatch shapeBatch(&geometryArena, SHAPE_COUNT);
+	shapeBatch.add(cubeMesh, cubeTransform.getModelMatrix());
+	shapeBatch.add(planeMesh, planeTransform.getModelMatrix());
+	shapeBatch.add(cylinderMesh, cylinderTransform.getModelMatrix());
+	shapeBatch.add(sphereMesh, sphereTransform.getModelMatrix());
+	for (int i = 0; i < SHAPE_COUNT; i++)
+		shapeModelVersions[i] = shapeTransforms[i]->getVersion();
+	shapeBatch.upload();
 
 	resetCamera(camera, cameraController);
 
@@ -141,21 +161,19 @@ int main() {
 		ew::Vec3 lightF = ew::Vec3(sinf(lightRot.y) * cosf(lightRot.x), sinf(lightRot.x), -cosf(lightRot.y) * cosf(lightRot.x));
 		shader.setVec3("_LightDir", lightF);
 
-		// Draw cube
-		shader.setMat4("_Model", cubeTransform.getModelMatrix());
-		cubeMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
-
-		// Plane
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
-		planeMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
-
-		// cylinder
-		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
-		cylinderMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
-
-		// sphere
-		shader.setMat4("_Model", sphereTransform.getModelMatrix());
-		sphereMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
+		// Draw every shape
+		bool shapesMoved = false;
+		for (int i = 0; i < SHAPE_COUNT; i++)
+		{
+			if (shapeModelVersions[i] == shapeTransforms[i]->getVersion())
+				continue;
+			shapeBatch.setModel(i, shapeTransforms[i]->getModelMatrix());
+			shapeModelVersions[i] = shapeTransforms[i]->getVersion();
+			shapesMoved = true;
+		}
+		if (shapesMoved)
+			shapeBatch.upload();
+		shapeBatch.draw((ew::DrawMode)appSettings.drawAsPoints);
 
 
 		//Render UI
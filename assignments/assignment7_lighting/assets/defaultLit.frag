@@ -9,52 +9,48 @@ in Surface {
 
 uniform sampler2D _Texture;
 
-struct Light {
-    vec3 position;
-    vec3 color;
+#include "camera.glsl"
+#include "frame.glsl"
+#include "lighting.glsl"
+
+// Lights binned per cluster on the CPU by ew::LightClusters
+layout(std140) uniform ClusterBlock {
+    uvec3 _ClusterGridSize;
+    vec2 _ScreenSize;
+    float _SliceScale;
+    float _SliceBias;
 };
 
-uniform Light _Lights[5];
-uniform int _numLights;
-
-struct Material {
-    float ambientK;
-    float diffuseK;
-    float specular;
-    float shininess;
+layout(std430) readonly buffer ClusterGridBlock {
+    uvec2 _ClusterGrid[]; // Offset into _ClusterLightIndices, light count
 };
 
-uniform Material _Material;
+layout(std430) readonly buffer ClusterIndexBlock {
+    uint _ClusterLightIndices[];
+};
 
-uniform vec3 _Camerapose;
+uint clusterIndex(vec3 worldPosition) {
+    float viewDepth = -(_View * vec4(worldPosition, 1.0)).z;
+    uvec2 tile = uvec2(gl_FragCoord.xy / _ScreenSize * vec2(_ClusterGridSize.xy));
+    uint slice = uint(max(log(viewDepth) * _SliceScale - _SliceBias, 0.0));
+    tile = min(tile, _ClusterGridSize.xy - 1u);
+    slice = min(slice, _ClusterGridSize.z - 1u);
+    return tile.x + _ClusterGridSize.x * (tile.y + _ClusterGridSize.y * slice);
+}
 
 void main() 
 {
     vec3 normal = normalize(fs_in.WorldNormal);
-    vec3 viewDir = normalize(_Camerapose - fs_in.WorldPosition);
+    vec3 viewDir = normalize(_CameraPosition - fs_in.WorldPosition);
 
-    vec3 totalAmbient = vec3(0.0);
+    vec3 totalAmbient = _AmbientLight * _Material.ambientK;
     vec3 totalDiffuse = vec3(0.0);
     vec3 totalSpecular = vec3(0.0);
 
-    for (int i = 0; i < _numLights; i++) {
-        vec3 lightDir = normalize(_Lights[i].position - fs_in.WorldPosition);
-
-        // Diffuse
-        float diff = max(dot(normal, lightDir), 0.0);
-        vec3 diffuse = _Lights[i].color * _Material.diffuseK * diff;
-
-        // Specular
-        vec3 halfwayDir = normalize(lightDir + viewDir);
-        float spec = pow(max(dot(normal, halfwayDir), 0.0), _Material.shininess * _Material.specular);
-        vec3 specular = _Lights[i].color * spec;
-
-        // Ambient
-        vec3 ambient = _Lights[i].color * _Material.ambientK;
-
-        totalAmbient += ambient;
-        totalDiffuse += diffuse;
-        totalSpecular += specular;
+    uvec2 cluster = _ClusterGrid[clusterIndex(fs_in.WorldPosition)];
+    for (uint c = 0u; c < cluster.y; c++) {
+        uint i = _ClusterLightIndices[cluster.x + c];
+        addPointLight(_Lights[i], fs_in.WorldPosition, normal, viewDir, totalDiffuse, totalSpecular);
     }
 
     vec3 finalColor = texture(_Texture, fs_in.UV).rgb * (totalAmbient + totalDiffuse + totalSpecular);
@@ -10,11 +10,13 @@ out Surface{
 }vs_out;
 
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+uniform mat4 _NormalMatrix; //transpose(inverse(_Model)), computed on the CPU
+
+#include "camera.glsl"
 
 void main(){
 	vs_out.UV = vUV;
 	vs_out.WorldPosition = (_Model * vec4(vPos, 1.0)).xyz;
-	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
+	vs_out.WorldNormal = mat3(_NormalMatrix) * vNormal;
 	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
 }
\ No newline at end of file
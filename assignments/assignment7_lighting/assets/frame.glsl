@@ -0,0 +1,6 @@
+// Uploaded once per frame through ew::UniformBuffer
+layout(std140) uniform FrameBlock {
+    int _numLights;
+    float _Time;
+    vec3 _AmbientLight; // Every light's color * intensity, ambient doesn't fall off with distance
+};
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <string>
+#include <vector>
 #include <random>
+#include <thread>
 
 #include <ew/external/glad.h>
 #include <ew/ewMath/ewMath.h>
@@ -11,9 +14,18 @@
 #include <imgui_impl_opengl3.h>
 
 #include <ew/shader.h>
+#include <ew/glStateCache.h>
+#include <ew/renderQueue.h>
+#include <ew/uniformBuffer.h>
+#include <ew/streamBuffer.h>
+#include <ew/lightBuffer.h>
+#include <ew/lightClusters.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
 #include <ew/transform.h>
+#include <ew/transformBatch.h>
+#include <ew/frustum.h>
+#include <ew/bvh.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
 
@@ -32,6 +44,7 @@ ew::CameraController cameraController;
 struct Light {
 	ew::Vec3 position = ew::Vec3(0.0, 0.0, 0.0);
 	ew::Vec3 color = ew::Vec3(0.0, 0.0, 0.0);
+	float radius = 10.0f;
 };
 
 struct Material {
@@ -65,9 +78,10 @@ int main() {
 	ImGui_ImplGlfw_InitForOpenGL(window, true);
 	ImGui_ImplOpenGL3_Init();
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
+	ew::GLStateCache& glState = ew::getGLStateCache();
+	glState.enable(GL_CULL_FACE);
+	glState.cullFace(GL_BACK);
+	glState.enable(GL_DEPTH_TEST);
 
 	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
 	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg", GL_REPEAT, GL_LINEAR);
@@ -75,14 +89,16 @@ int main() {
 	ew::Shader unlitShader("assets/unlit.vert", "assets/unlit.frag");
 
 	ew::Mesh cubeMesh(ew::createCube(1.0f));
-	ew::Mesh planeMesh(ew::createPlane(5.0f, 5.0f, 10));
+	const int PLANE_SUBDIVISIONS = 10;
+	//Dynamic, since the ripple updates its vertices
+	ew::Mesh planeMesh(ew::createPlane(5.0f, 5.0f, PLANE_SUBDIVISIONS), true);
 	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
 	ew::Mesh cylinderMesh(ew::createCylinder(0.5f, 1.0f, 32));
 
 	ew::Mesh lightMesh(ew::createSphere(0.2f, 64));
 
 	// Initialize lights
-	const int LIGHT_MAX = 5;
+	const int LIGHT_MAX = 1024;
 	int numLights = 1;
 	Light lights[LIGHT_MAX];
 	Material material1;
@@ -98,23 +114,100 @@ int main() {
 		lights[i].color = ew::Vec3(colorDis(gen), colorDis(gen), colorDis(gen));
 	}
 
+	// Materials bind their first texture to unit 0. Per draw uniforms are set by the render queue.
+	ew::UniformHandle textureUniform = shader.getUniform("_Texture");
+	shader.use();
+	shader.setInt(textureUniform, 0);
+
+	// Camera, lights and material are uniform blocks, all uploaded in one call per frame
+	shader.bindUniformBlock("CameraBlock", ew::UNIFORM_BINDING_CAMERA);
+	shader.bindUniformBlock("FrameBlock", ew::UNIFORM_BINDING_FRAME);
+	shader.bindUniformBlock("MaterialBlock", ew::UNIFORM_BINDING_MATERIAL);
+	shader.bindUniformBlock("ClusterBlock", ew::UNIFORM_BINDING_CLUSTERS);
+	unlitShader.bindUniformBlock("CameraBlock", ew::UNIFORM_BINDING_CAMERA);
+	ew::UniformBuffer uniformBuffer(sizeof(ew::CameraUniforms) + sizeof(ew::FrameUniforms) + sizeof(ew::MaterialUniforms)
+		+ sizeof(ew::ClusterUniforms), 4);
+	ew::CameraUniforms cameraUniforms;
+	ew::FrameUniforms frameUniforms = {};
+
+	// Lights live in a shader storage buffer, so LIGHT_MAX is only a CPU side limit
+	shader.bindStorageBlock("LightBlock", ew::STORAGE_BINDING_LIGHTS);
+	ew::LightBuffer lightBuffer(LIGHT_MAX);
+	lightBuffer.resize(LIGHT_MAX);
+
+	// Clustered lighting: each fragment only loops over the lights binned into its cluster
+	shader.bindStorageBlock("ClusterGridBlock", ew::STORAGE_BINDING_CLUSTER_GRID);
+	shader.bindStorageBlock("ClusterIndexBlock", ew::STORAGE_BINDING_CLUSTER_INDICES);
+	ew::LightClusters lightClusters(16, 9, 24);
+	int binningThreads = (int)std::thread::hardware_concurrency();
+
 	// Initialize transforms
-	ew::Transform cubeTransform;
-	ew::Transform planeTransform;
-	ew::Transform sphereTransform;
-	ew::Transform cylinderTransform;
+	ew::CachedTransform cubeTransform;
+	ew::CachedTransform planeTransform;
+	ew::CachedTransform sphereTransform;
+	ew::CachedTransform cylinderTransform;
 	ew::Transform lightsTransform[LIGHT_MAX];
-	planeTransform.position = ew::Vec3(0, -1.0, 0);
-	sphereTransform.position = ew::Vec3(-1.5f, 0.0f, 0.0f);
-	cylinderTransform.position = ew::Vec3(1.5f, 0.0f, 0.0f);
+	ew::TransformStream lightsTransformStream;
+	ew::Mat4 lightsModelMatrices[LIGHT_MAX];
+	planeTransform.setPosition(ew::Vec3(0, -1.0, 0));
+	sphereTransform.setPosition(ew::Vec3(-1.5f, 0.0f, 0.0f));
+	cylinderTransform.setPosition(ew::Vec3(1.5f, 0.0f, 0.0f));
 
 	for (int i = 0; i < LIGHT_MAX; i++)
 		lightsTransform[i].position = lights[i].position;
 
+	// Culling and picking both go through a BVH of world bounds, which are only recomputed
+	// when an object's transform version changes
+	const int OBJECT_COUNT = 4;
+	const ew::Mesh* objectMeshes[OBJECT_COUNT] = { &cubeMesh, &planeMesh, &sphereMesh, &cylinderMesh };
+	const ew::CachedTransform* objectTransforms[OBJECT_COUNT] = { &cubeTransform, &planeTransform, &sphereTransform, &cylinderTransform };
+	const char* objectNames[OBJECT_COUNT] = { "Cube", "Plane", "Sphere", "Cylinder" };
+	unsigned int objectBoundsVersions[OBJECT_COUNT];
+	unsigned char objectsVisible[OBJECT_COUNT];
+	std::vector<int> visibleObjects;
+	ew::AABB objectWorldBounds[OBJECT_COUNT];
+	auto updateObjectBounds = [&](int i) {
+		objectWorldBounds[i] = ew::TransformAABB(objectTransforms[i]->getModelMatrix(), objectMeshes[i]->getBounds());
+		objectBoundsVersions[i] = objectTransforms[i]->getVersion();
+	};
+	for (int i = 0; i < OBJECT_COUNT; i++)
+		updateObjectBounds(i);
+
+	// Left click casts a ray through the BVH to pick an object
+	ew::BVH objectBVH;
+	objectBVH.build(objectWorldBounds, OBJECT_COUNT);
+	int pickedObject = -1;
+	bool prevLeftMouse = false;
+
+	ew::Vec3Stream lightCenters;
+	float lightRadii[LIGHT_MAX];
+	unsigned char lightsVisible[LIGHT_MAX];
+	for (int i = 0; i < LIGHT_MAX; i++)
+		lightRadii[i] = lightMesh.getBounds().extents().x;
+	bool frustumCulling = true;
+
+	// Ripple: a wave crest rolls across the plane. Only rows whose height changed are updated,
+	// and adjacent rows are merged into one upload.
+	bool ripple = false;
+	const int PLANE_COLUMNS = PLANE_SUBDIVISIONS + 1;
+	const float RIPPLE_HEIGHT = 0.15f;
+	const float RIPPLE_HALF_WIDTH = 0.75f;
+	float planeRowHeights[PLANE_COLUMNS] = {};
+	ew::Vertex planeRow[PLANE_COLUMNS];
+	size_t planeBytesUploaded = 0;
+
+	// Draws are sorted by program, material and mesh each frame instead of running in code order
+	ew::RenderQueue renderQueue;
+	ew::RenderMaterial brickMaterial;
+	brickMaterial.textures[0] = brickTexture;
+
 	resetCamera(camera, cameraController);
+	// Texture loading bound textures without the cache
+	glState.invalidate();
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
+		glState.beginFrame();
 
 		float time = (float)glfwGetTime();
 		float deltaTime = time - prevTime;
@@ -127,47 +220,129 @@ int main() {
 		glClearColor(bgColor.x, bgColor.y, bgColor.z, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		shader.use();
-		glBindTexture(GL_TEXTURE_2D, brickTexture);
-		shader.setInt("_Texture", 0);
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		ew::Mat4 view = camera.ViewMatrix();
+		ew::Mat4 projection = camera.ProjectionMatrix();
+		ew::Mat4 viewProjection = projection * view;
+		ew::Frustum frustum = ew::ExtractFrustum(viewProjection);
 
-		shader.setMat4("_Model", cubeTransform.getModelMatrix());
-		cubeMesh.draw();
+		float crestZ = ripple ? fmodf(time * 1.5f, 5.0f + 2.0f * RIPPLE_HALF_WIDTH) - 2.5f - RIPPLE_HALF_WIDTH : -100.0f;
+		for (int row = 0; row < PLANE_COLUMNS; row++)
+		{
+			const ew::Vertex* vertices = planeMesh.getVertices() + row * PLANE_COLUMNS;
+			// cos^2 bump around the crest, and its slope for the normal
+			float u = ew::PI * 0.5f * (vertices[0].pos.z - crestZ) / RIPPLE_HALF_WIDTH;
+			bool inside = fabsf(u) < ew::PI * 0.5f;
+			float height = inside ? RIPPLE_HEIGHT * cosf(u) * cosf(u) : 0.0f;
+			float slope = inside ? -RIPPLE_HEIGHT * sinf(2.0f * u) * ew::PI * 0.5f / RIPPLE_HALF_WIDTH : 0.0f;
+			if (height == planeRowHeights[row])
+				continue;
+			planeRowHeights[row] = height;
+			for (int col = 0; col < PLANE_COLUMNS; col++)
+			{
+				planeRow[col] = vertices[col];
+				planeRow[col].pos.y = height;
+				planeRow[col].normal = ew::Normalize(ew::Vec3(0.0f, 1.0f, -slope));
+			}
+			planeMesh.update(row * PLANE_COLUMNS, planeRow, PLANE_COLUMNS);
+		}
+		planeBytesUploaded = planeMesh.upload();
+		if (planeBytesUploaded > 0) {
+			updateObjectBounds(1);
+			objectBVH.setItemBounds(1, objectWorldBounds[1]);
+		}
 
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
-		planeMesh.draw();
+		for (int i = 0; i < OBJECT_COUNT; i++)
+		{
+			if (objectBoundsVersions[i] == objectTransforms[i]->getVersion())
+				continue;
+			updateObjectBounds(i);
+			objectBVH.setItemBounds(i, objectWorldBounds[i]);
+		}
 
-		shader.setMat4("_Model", sphereTransform.getModelMatrix());
-		sphereMesh.draw();
+		bool leftMouse = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1) != 0;
+		if (leftMouse && !prevLeftMouse && !ImGui::GetIO().WantCaptureMouse) {
+			double mouseX, mouseY;
+			glfwGetCursorPos(window, &mouseX, &mouseY);
+			ew::Ray ray = camera.ScreenPointToRay((float)mouseX, (float)mouseY, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT);
+			pickedObject = objectBVH.raycast(ray, camera.farPlane);
+		}
+		prevLeftMouse = leftMouse;
 
-		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
-		cylinderMesh.draw();
+		visibleObjects.clear();
+		objectBVH.queryFrustum(frustum, visibleObjects);
+		memset(objectsVisible, 0, sizeof(objectsVisible));
+		for (int i : visibleObjects)
+			objectsVisible[i] = 1;
+		int numVisible = 0;
 
-		// Render point lights
-		shader.setInt("_numLights", numLights);
-		shader.setVec3("_Camerapose", camera.position);
-		shader.setFloat("_Material.ambientK", material1.ambientK);
-		shader.setFloat("_Material.diffuseK", material1.diffuseK);
-		shader.setFloat("_Material.specular", material1.specular);
-		shader.setFloat("_Material.shininess", material1.shininess);
+		for (int i = 0; i < numLights; i++)
+			lights[i].position = lightsTransform[i].position;
 
+		uniformBuffer.beginFrame();
+		cameraUniforms.viewProjection = viewProjection;
+		cameraUniforms.view = view;
+		cameraUniforms.projection = projection;
+		cameraUniforms.position = camera.position;
+		frameUniforms.numLights = numLights;
+		frameUniforms.time = time;
+		//Only lights that changed since last frame are uploaded
 		for (int i = 0; i < numLights; i++)
 		{
-			lights[i].position = lightsTransform[i].position;
-			shader.setVec3("_Lights[" + std::to_string(i) + "].color", lights[i].color);
-			shader.setVec3("_Lights[" + std::to_string(i) + "].position", lights[i].position);
+			lightBuffer.setPosition(i, lights[i].position);
+			lightBuffer.setColor(i, lights[i].color);
+			lightBuffer.setRadius(i, lights[i].radius);
+		}
+		frameUniforms.ambientLight = lightBuffer.getTotalColor(numLights);
+		lightBuffer.upload();
+		lightBuffer.bind(ew::STORAGE_BINDING_LIGHTS);
+		lightClusters.update(camera, lightBuffer.getLights(), numLights, binningThreads);
+		lightClusters.upload();
+		lightClusters.bind();
+		ew::ClusterUniforms clusterUniforms = lightClusters.getUniforms((float)SCREEN_WIDTH, (float)SCREEN_HEIGHT);
+		ew::MaterialUniforms materialUniforms = { material1.ambientK, material1.diffuseK, material1.specular, material1.shininess };
+		ew::UniformRange cameraRange = uniformBuffer.push(cameraUniforms);
+		ew::UniformRange frameRange = uniformBuffer.push(frameUniforms);
+		ew::UniformRange materialRange = uniformBuffer.push(materialUniforms);
+		ew::UniformRange clusterRange = uniformBuffer.push(clusterUniforms);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_CAMERA, cameraRange);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_FRAME, frameRange);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_MATERIAL, materialRange);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_CLUSTERS, clusterRange);
+
+		renderQueue.begin(camera);
+		ew::RenderItem item;
+		item.shader = &shader;
+		item.material = &brickMaterial;
+		for (int i = 0; i < OBJECT_COUNT; i++)
+		{
+			if (frustumCulling && !objectsVisible[i])
+				continue;
+			item.mesh = objectMeshes[i];
+			item.model = objectTransforms[i]->getModelMatrix();
+			item.normalMatrix = objectTransforms[i]->getNormalMatrix();
+			renderQueue.submit(item);
+			numVisible++;
 		}
 
-		unlitShader.use();
-		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
-
+		// Point lights
+		item = ew::RenderItem();
+		item.shader = &unlitShader;
+		item.mesh = &lightMesh;
+		lightsTransformStream.load(lightsTransform, numLights);
+		ew::computeModelMatrices(lightsTransformStream, lightsModelMatrices);
+		lightCenters.resize(numLights);
+		for (int i = 0; i < numLights; i++)
+			lightCenters.set(i, lightsTransform[i].position);
+		ew::CullSpheres(frustum, lightCenters, lightRadii, lightsVisible);
 		for (int i = 0; i < numLights; i++)
 		{
-			unlitShader.setMat4("_Model", lightsTransform[i].getModelMatrix());
-			unlitShader.setVec3("_Color", lights[i].color);
-			lightMesh.draw();
+			if (frustumCulling && !lightsVisible[i])
+				continue;
+			item.model = lightsModelMatrices[i];
+			item.color = lights[i].color;
+			renderQueue.submit(item);
 		}
+		renderQueue.draw();
 
 		// Render UI
 		{
@@ -195,8 +370,18 @@ int main() {
 				}
 			}
 			ImGui::ColorEdit3("BG color", &bgColor.x);
+			ImGui::Checkbox("Frustum Culling", &frustumCulling);
+			ImGui::Checkbox("Ripple plane", &ripple);
+			ImGui::Text("Plane bytes uploaded: %zu", planeBytesUploaded);
+			ImGui::Text("Mesh staging fence waits: %i", ew::getMeshStagingBuffer().getNumFenceWaits());
+			ImGui::Text("Objects drawn: %i / %i", numVisible, OBJECT_COUNT);
+			ImGui::Text("Picked: %s", pickedObject >= 0 ? objectNames[pickedObject] : "None");
 
 			ImGui::SliderInt("Number of Lights", &numLights, 0, LIGHT_MAX);
+			ImGui::Text("Clustered light indices: %i", lightClusters.getNumIndices());
+			ImGui::Text("Queued draws: %i, state changes: %i", renderQueue.getNumDraws(), renderQueue.getNumStateChanges());
+			ImGui::Text("GL state calls: %i issued, %i skipped", glState.getNumIssued(), glState.getNumSkipped());
+			ImGui::Text("Uniform buffer fence waits: %i", uniformBuffer.getNumFenceWaits());
 
 			for (auto i = 0; i < numLights; i++)
 			{
@@ -204,6 +389,7 @@ int main() {
 				{
 					ImGui::DragFloat3("Light Position", &lightsTransform[i].position.x, 0.1f);
 					ImGui::ColorEdit3("Light Color", &lights[i].color.x);
+					ImGui::DragFloat("Light Radius", &lights[i].radius, 0.1f, 0.0f);
 				}
 			}
 
@@ -0,0 +1,7 @@
+// Uploaded once per render pass through ew::UniformBuffer
+layout(std140) uniform CameraBlock {
+    mat4 _ViewProjection;
+    mat4 _View;
+    mat4 _Projection;
+    vec3 _CameraPosition;
+};
@@ -11,18 +11,23 @@ out Surface {
 } vs_out;
 
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+uniform mat4 _NormalMatrix; //transpose(inverse(_Model)), computed on the CPU
 
-uniform float _Time;
-uniform float _UVSpeed; 
+#include "camera.glsl"
+#include "frame.glsl"
+
+// Variant features are defined by ew::ShaderVariants
+#ifdef UV_SCROLL
+uniform float _UVSpeed;
+#endif
 
 void main() {
     vs_out.UV = vUV;
-    
-    vec2 animatedUV = vUV + vec2(_Time * _UVSpeed, _Time * _UVSpeed);
-    vs_out.UV = animatedUV;
+#ifdef UV_SCROLL
+    vs_out.UV += vec2(_Time * _UVSpeed, _Time * _UVSpeed);
+#endif
 
     vs_out.WorldPosition = (_Model * vec4(vPos, 1.0)).xyz;
-    vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
+    vs_out.WorldNormal = mat3(_NormalMatrix) * vNormal;
     gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+// Point lights from ew::LightBuffer and the material block, shared by every lit shader
+
+struct Light {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+layout(std430) readonly buffer LightBlock {
+    Light _Lights[];
+};
+
+struct Material {
+    float ambientK;
+    float diffuseK;
+    float specular;
+    float shininess;
+};
+
+layout(std140) uniform MaterialBlock {
+    Material _Material;
+};
+
+// Adds one light's diffuse and specular Blinn-Phong terms. Ambient comes from _AmbientLight instead,
+// so it still reaches fragments outside the light's radius.
+void addPointLight(Light light, vec3 worldPosition, vec3 normal, vec3 viewDir,
+    inout vec3 totalDiffuse, inout vec3 totalSpecular) {
+    vec3 toLight = light.position - worldPosition;
+    float dist = length(toLight);
+    if (dist >= light.radius)
+        return;
+    vec3 lightDir = toLight / dist;
+    // Smooth falloff to zero at the light's radius
+    float falloff = clamp(1.0 - pow(dist / light.radius, 4.0), 0.0, 1.0);
+    vec3 lightColor = light.color * light.intensity * falloff * falloff;
+
+    // Diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+    totalDiffuse += lightColor * _Material.diffuseK * diff;
+
+    // Specular
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), _Material.shininess * _Material.specular);
+    totalSpecular += lightColor * spec;
+}
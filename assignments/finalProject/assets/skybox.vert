@@ -3,11 +3,10 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "camera.glsl"
 
 void main()
 {
     TexCoords = aPos;  
-    gl_Position = projection * view * vec4(aPos, 1.0);
+    gl_Position = _Projection * _View * vec4(aPos, 1.0);
 }
@@ -4,7 +4,7 @@ layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
 
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+#include "camera.glsl"
 
 void main(){
 	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
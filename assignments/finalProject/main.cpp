@@ -10,6 +10,11 @@
 #include <imgui_impl_opengl3.h>
 
 #include <ew/shader.h>
+#include <ew/glStateCache.h>
+#include <ew/shaderLibrary.h>
+#include <ew/shaderVariants.h>
+#include <ew/uniformBuffer.h>
+#include <ew/lightBuffer.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
 #include <ew/transform.h>
@@ -38,6 +43,7 @@ int scale = 50;
 struct Light {
 	ew::Vec3 position = ew::Vec3(0.0, 0.0, 0.0);
 	ew::Vec3 color = ew::Vec3(0.0, 0.0, 0.0);
+	float radius = 10.0f;
 };
 
 struct Material {
@@ -47,6 +53,13 @@ struct Material {
 	float shininess = (float)128.0;
 };
 
+// Feature bits of the defaultLit variants, in the order of the defines passed to ShaderVariants
+enum LitFeature {
+	LIT_NORMAL_MAP = 1 << 0,
+	LIT_SKYBOX_REFLECTION = 1 << 1,
+	LIT_UV_SCROLL = 1 << 2
+};
+
 std::string faces[6]
 {
 		"assets/skybox/right.jpg",
@@ -82,12 +95,22 @@ int main() {
 	ImGui_ImplGlfw_InitForOpenGL(window, true);
 	ImGui_ImplOpenGL3_Init();
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
-
-	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
-	ew::Shader skyBoxShader("assets/skybox.vert", "assets/skybox.frag");
+	// State that changes during a frame goes through the cache, so setting it again every frame is free
+	ew::GLStateCache& glState = ew::getGLStateCache();
+	glState.enable(GL_CULL_FACE);
+	glState.cullFace(GL_BACK);
+	glState.enable(GL_DEPTH_TEST);
+
+	// Lit and skybox programs compile in the background while textures load. Until they are ready,
+	// the pond is drawn with the unlit fallback and the skybox is skipped.
+	ew::ShaderLibrary shaderLibrary;
+	shaderLibrary.setFallback("assets/unlit.vert", "assets/unlit.frag");
+	ew::ShaderVariants litShaders(&shaderLibrary, "assets/defaultLit.vert", "assets/defaultLit.frag",
+		{ "NORMAL_MAP", "SKYBOX_REFLECTION", "UV_SCROLL" });
+	litShaders.prepare(LIT_NORMAL_MAP | LIT_SKYBOX_REFLECTION | LIT_UV_SCROLL);
+	int skyBoxShaderId = shaderLibrary.add("assets/skybox.vert", "assets/skybox.frag");
+	// Saving a shader or one of its includes in the bin/assets folder recompiles the programs that use it
+	shaderLibrary.enableHotReload();
 
 	unsigned int waterTexture = ew::loadTexture("assets/water_texture.jpg", GL_REPEAT, GL_LINEAR);
 	unsigned int normalMapTexture = ew::loadTexture("assets/pond_normal_map.jpg", GL_REPEAT, GL_LINEAR);
@@ -110,22 +133,78 @@ int main() {
 		lights[i].color = ew::Vec3(1.0, 1.0, 1.0);
 	}
 
+	// Resolve uniform locations so the render loop never builds or looks up uniform names.
+	// Redone whenever the program in use changes: a different variant, a fallback being replaced, or a reload.
+	// Uniforms a variant compiled out resolve to invalid handles, and setting those does nothing.
+	ew::UniformHandle reflectionBlendFactorUniform, normalMapStrengthUniform, uvSpeedUniform, textureUniform;
+	ew::UniformHandle normalMapUniform, litSkyBoxUniform, modelUniform, normalMatrixUniform, skyBoxUniform;
+	unsigned int litProgram = 0, skyBoxProgram = 0;
+	auto resolveLitShader = [&](const ew::Shader& shader) {
+		litProgram = shader.getProgram();
+		reflectionBlendFactorUniform = shader.getUniform("_ReflectionBlendFactor");
+		normalMapStrengthUniform = shader.getUniform("_NormalMapStrength");
+		uvSpeedUniform = shader.getUniform("_UVSpeed");
+		textureUniform = shader.getUniform("_Texture");
+		normalMapUniform = shader.getUniform("_NormalMap");
+		litSkyBoxUniform = shader.getUniform("skybox");
+		modelUniform = shader.getUniform("_Model");
+		normalMatrixUniform = shader.getUniform("_NormalMatrix");
+
+		// Camera, lights and material are uniform blocks, all uploaded in one call per frame
+		shader.bindUniformBlock("CameraBlock", ew::UNIFORM_BINDING_CAMERA);
+		shader.bindUniformBlock("FrameBlock", ew::UNIFORM_BINDING_FRAME);
+		shader.bindUniformBlock("MaterialBlock", ew::UNIFORM_BINDING_MATERIAL);
+		shader.bindStorageBlock("LightBlock", ew::STORAGE_BINDING_LIGHTS);
+	};
+	auto resolveSkyBoxShader = [&](const ew::Shader& skyBoxShader) {
+		skyBoxProgram = skyBoxShader.getProgram();
+		skyBoxUniform = skyBoxShader.getUniform("skybox");
+		skyBoxShader.bindUniformBlock("CameraBlock", ew::UNIFORM_BINDING_CAMERA);
+	};
+	unlitShader.bindUniformBlock("CameraBlock", ew::UNIFORM_BINDING_CAMERA);
+	ew::UniformBuffer uniformBuffer(sizeof(ew::CameraUniforms) + sizeof(ew::FrameUniforms) + sizeof(ew::MaterialUniforms), 3);
+	ew::CameraUniforms cameraUniforms;
+	ew::FrameUniforms frameUniforms = {};
+
+	ew::LightBuffer lightBuffer(LIGHT_MAX);
+	lightBuffer.resize(LIGHT_MAX);
+
 	// Initialize transforms
-	ew::Transform pondTransform;
-	pondTransform.position = ew::Vec3(0, -1.0, 0);
+	ew::CachedTransform pondTransform;
+	pondTransform.setPosition(ew::Vec3(0, -1.0, 0));
 
 	for (int i = 0; i < LIGHT_MAX; i++)
-		lights[i].position = pondTransform.position;
+		lights[i].position = pondTransform.getPosition();
 
 	resetCamera(camera, cameraController);
 
 	// Initalize skyboxVAO
 	unsigned int skyboxVAO = MyLib::generateSkyboxVAO(50);
+	// Texture loading and the skybox VAO bound objects without the cache
+	glState.invalidate();
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
-
-		glDisable(GL_CULL_FACE);
+		glState.beginFrame();
+
+		// The pond's variant only has the features its current settings actually use
+		uint32_t pondFeatures = 0;
+		if (_NormalMapStrength > 0.0f)
+			pondFeatures |= LIT_NORMAL_MAP;
+		if (_ReflectionBlendFactor > 0.0f)
+			pondFeatures |= LIT_SKYBOX_REFLECTION;
+		if (_UVSpeed != 0.0f)
+			pondFeatures |= LIT_UV_SCROLL;
+
+		shaderLibrary.update();
+		const ew::Shader& shader = litShaders.get(pondFeatures);
+		const ew::Shader& skyBoxShader = shaderLibrary.get(skyBoxShaderId);
+		if (shader.getProgram() != litProgram)
+			resolveLitShader(shader);
+		if (skyBoxShader.getProgram() != skyBoxProgram)
+			resolveSkyBoxShader(skyBoxShader);
+
+		glState.disable(GL_CULL_FACE);
 
 		float time = (float)glfwGetTime();
 		float deltaTime = time - prevTime;
@@ -138,72 +217,72 @@ int main() {
 		glClearColor(bgColor.x, bgColor.y, bgColor.z, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		for (int i = 0; i < numLights; i++)
+			lights[i].position = pondTransform.getPosition();
+
+		uniformBuffer.beginFrame();
+		cameraUniforms.view = camera.ViewMatrix();
+		cameraUniforms.projection = camera.ProjectionMatrix();
+		cameraUniforms.viewProjection = cameraUniforms.projection * cameraUniforms.view;
+		cameraUniforms.position = camera.position;
+		frameUniforms.numLights = numLights;
+		frameUniforms.time = time;
+		//Only lights that changed since last frame are uploaded
+		for (int i = 0; i < numLights; i++)
+		{
+			lightBuffer.setPosition(i, lights[i].position);
+			lightBuffer.setColor(i, lights[i].color);
+			lightBuffer.setRadius(i, lights[i].radius);
+		}
+		frameUniforms.ambientLight = lightBuffer.getTotalColor(numLights);
+		lightBuffer.upload();
+		lightBuffer.bind(ew::STORAGE_BINDING_LIGHTS);
+		ew::MaterialUniforms materialUniforms = { material1.ambientK, material1.diffuseK, material1.specular, material1.shininess };
+		ew::UniformRange cameraRange = uniformBuffer.push(cameraUniforms);
+		ew::UniformRange frameRange = uniformBuffer.push(frameUniforms);
+		ew::UniformRange materialRange = uniformBuffer.push(materialUniforms);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_CAMERA, cameraRange);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_FRAME, frameRange);
+		uniformBuffer.bind(ew::UNIFORM_BINDING_MATERIAL, materialRange);
+
 		//Skybox
-		glDepthMask(GL_FALSE);
-		glEnable(GL_DEPTH_TEST);
+		glState.depthMask(false);
+		glState.enable(GL_DEPTH_TEST);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		skyBoxShader.use();
-		skyBoxShader.setMat4("projection", camera.ProjectionMatrix());
-		skyBoxShader.setMat4("view", camera.ViewMatrix());
+		if (shaderLibrary.isReady(skyBoxShaderId)) {
+			skyBoxShader.use();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skyBoxTexture);
-		skyBoxShader.setInt("skybox", 3);
+			glState.bindTexture(3, GL_TEXTURE_CUBE_MAP, skyBoxTexture);
+			skyBoxShader.setInt(skyBoxUniform, 3);
 
-		// Bind the skybox VAO
-		glBindVertexArray(skyboxVAO);
-
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// Unbind the skybox VAO
-		glBindVertexArray(0);
-
-		glDepthMask(GL_TRUE);
+			glState.bindVertexArray(skyboxVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
 
-		glDepthMask(GL_TRUE);
+		glState.depthMask(true);
 
 		shader.use();
-		shader.setFloat("_Time", time);
 
 		// refraction unfiforms
-		shader.setFloat("_ReflectionBlendFactor", _ReflectionBlendFactor);
-		shader.setFloat("_NormalMapStrength", _NormalMapStrength);
-		shader.setFloat("_UVSpeed", _UVSpeed);
+		shader.setFloat(reflectionBlendFactorUniform, _ReflectionBlendFactor);
+		shader.setFloat(normalMapStrengthUniform, _NormalMapStrength);
+		shader.setFloat(uvSpeedUniform, _UVSpeed);
 		// Bind textures to texture units
-		glActiveTexture(GL_TEXTURE1);
+		glState.bindTexture(1, GL_TEXTURE_2D, waterTexture);
+		shader.setInt(textureUniform, 1);
 
-		glBindTexture(GL_TEXTURE_2D, waterTexture);
-		shader.setInt("_Texture", 1);
+		glState.bindTexture(2, GL_TEXTURE_CUBE_MAP, skyBoxTexture);
+		shader.setInt(litSkyBoxUniform, 2);
 
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skyBoxTexture);
-		skyBoxShader.setInt("skybox", 2);
+		glState.bindTexture(3, GL_TEXTURE_2D, normalMapTexture);
+		shader.setInt(normalMapUniform, 3);
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, normalMapTexture);
-		shader.setInt("_NormalMap", 3);
-
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
-		shader.setMat4("_Model", pondTransform.getModelMatrix());
+		shader.setMat4(modelUniform, pondTransform.getModelMatrix());
+		shader.setMat4(normalMatrixUniform, pondTransform.getNormalMatrix());
 		pondMesh.draw();
 
-		// Render point lights
-		shader.setInt("_numLights", numLights);
-		shader.setVec3("_Camerapose", camera.position);
-		shader.setFloat("_Material.ambientK", material1.ambientK);
-		shader.setFloat("_Material.diffuseK", material1.diffuseK);
-		shader.setFloat("_Material.specular", material1.specular);
-		shader.setFloat("_Material.shininess", material1.shininess);
-
-		for (int i = 0; i < numLights; i++) {
-			lights[i].position = pondTransform.position;
-			shader.setVec3("_Lights[" + std::to_string(i) + "].color", lights[i].color);
-			shader.setVec3("_Lights[" + std::to_string(i) + "].position", lights[i].position);
-		}
-
 		unlitShader.use();
-		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
 
 		// Render UI
 		{
@@ -231,10 +310,17 @@ int main() {
 				}
 			}
 
+			if (!shaderLibrary.allDone())
+				ImGui::Text("Compiling shaders: %i left%s", shaderLibrary.getNumPending(), shaderLibrary.isParallel() ? " (parallel)" : "");
 			ImGui::SliderFloat("Specular Intensity", &material1.specular, 0.0f, 1.0f, "Intensity: %.2f");
 			ImGui::SliderFloat("_ReflectionBlendFactor", &_ReflectionBlendFactor, 0.0f, 1.0f, "Blend Factor: %.2f");
 			ImGui::SliderFloat("_NormalMapStrength", &_NormalMapStrength, 0.0f, 2.0f, "Strength: %.2f");
-			ImGui::SliderFloat("_UVSpeed", &_UVSpeed, 0.01f, 1.0f, "Speed: %.2f");
+			ImGui::SliderFloat("_UVSpeed", &_UVSpeed, 0.0f, 1.0f, "Speed: %.2f");
+			ImGui::Text("Shader variant: %s%s%s (%i compiled)", pondFeatures & LIT_NORMAL_MAP ? "NORMAL_MAP " : "",
+				pondFeatures & LIT_SKYBOX_REFLECTION ? "SKYBOX_REFLECTION " : "", pondFeatures & LIT_UV_SCROLL ? "UV_SCROLL" : "",
+				litShaders.getNumVariants());
+			ImGui::Text("GL state calls: %i issued, %i skipped", glState.getNumIssued(), glState.getNumSkipped());
+			ImGui::Text("Uniform buffer fence waits: %i", uniformBuffer.getNumFenceWaits());
 
 			ImGui::End();
 
@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <stdint.h>
+
+namespace bench {
+	//Wall clock time since construction
+	class Timer {
+	public:
+		Timer() : m_start(std::chrono::high_resolution_clock::now()) {};
+		inline double getMilliseconds()const {
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count();
+		}
+	private:
+		std::chrono::high_resolution_clock::time_point m_start;
+	};
+
+	//Small deterministic generator, so every run times the same data
+	class Random {
+	public:
+		Random(uint32_t seed = 1) : m_state(seed ? seed : 1) {};
+		inline uint32_t next() {
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			return m_state;
+		}
+		//Uniform in [min, max)
+		inline float range(float min, float max) {
+			return min + (max - min) * (float)(next() >> 8) * (1.0f / 16777216.0f);
+		}
+	private:
+		uint32_t m_state;
+	};
+
+	//Each benchmark prints its timings and returns false if its cross-check failed
+	bool runMat4();
+	bool runBVH();
+	bool runLightClusters();
+	//GL benchmarks, see glContext.h. They are skipped, not failed, when there is no GL context.
+	bool runShaderCache();
+	bool runInstancing();
+}
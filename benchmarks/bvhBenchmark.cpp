@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "benchmark.h"
+#include "ew/bvh.h"
+#include "ew/ewMath/transformations.h"
+
+namespace bench {
+	static const int NUM_RAYS = 1000;
+
+	//Closest hit by testing every box, for checking BVH::raycast
+	static int raycastBruteForce(const std::vector<ew::AABB>& boxes, const ew::Ray& ray, float maxDistance, float* outDistance) {
+		ew::Vec3 invDirection = ew::Vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+		int closest = -1;
+		float closestDistance = maxDistance;
+		for (int i = 0; i < (int)boxes.size(); i++)
+		{
+			float distance;
+			if (ew::RayIntersects(ray, invDirection, boxes[i], closestDistance, &distance) && (closest < 0 || distance < closestDistance)) {
+				closest = i;
+				closestDistance = distance;
+			}
+		}
+		*outDistance = closestDistance;
+		return closest;
+	}
+
+	/// <summary>
+	/// Scales the BVH from 1k to 1M random boxes, at a constant density so each query sees a similar scene.
+	/// Times build, refit, a frustum query and ray casts, each against testing every box.
+	/// Fails if the BVH returns a different visible set or a different closest hit distance.
+	/// </summary>
+	bool runBVH() {
+		bool passed = true;
+		printf("%8s %10s %10s %12s %12s %10s %14s %14s\n", "items", "build ms", "refit ms", "frustum ms", "linear ms", "visible", "ray us", "linear ray us");
+		for (int count = 1000; count <= 1000000; count *= 10)
+		{
+			Random random(count);
+			//Boxes 0.5-2 units wide, ~8 units^3 of space each
+			float halfSize = cbrtf((float)count * 8.0f) * 0.5f;
+			std::vector<ew::AABB> boxes(count);
+			for (int i = 0; i < count; i++)
+			{
+				ew::Vec3 center = ew::Vec3(random.range(-halfSize, halfSize), random.range(-halfSize, halfSize), random.range(-halfSize, halfSize));
+				ew::Vec3 extents = ew::Vec3(random.range(0.25f, 1.0f), random.range(0.25f, 1.0f), random.range(0.25f, 1.0f));
+				boxes[i].min = center - extents;
+				boxes[i].max = center + extents;
+			}
+
+			ew::BVH bvh;
+			Timer buildTimer;
+			bvh.build(boxes.data(), count);
+			double buildMs = buildTimer.getMilliseconds();
+			Timer refitTimer;
+			bvh.refit(boxes.data());
+			double refitMs = refitTimer.getMilliseconds();
+
+			//Camera at the center of the scene, looking down -Z
+			ew::Mat4 view = ew::LookAt(ew::Vec3(0.0f), ew::Vec3(0.0f, 0.0f, -1.0f), ew::Vec3(0.0f, 1.0f, 0.0f));
+			ew::Mat4 projection = ew::Perspective(ew::Radians(60.0f), 16.0f / 9.0f, 0.1f, halfSize);
+			ew::Frustum frustum = ew::ExtractFrustum(projection * view);
+
+			std::vector<int> visible;
+			Timer queryTimer;
+			bvh.queryFrustum(frustum, visible);
+			double queryMs = queryTimer.getMilliseconds();
+			std::vector<int> linearVisible;
+			Timer linearTimer;
+			for (int i = 0; i < count; i++)
+			{
+				if (ew::Intersects(frustum, boxes[i]))
+					linearVisible.push_back(i);
+			}
+			double linearMs = linearTimer.getMilliseconds();
+			std::sort(visible.begin(), visible.end());
+			if (visible != linearVisible) {
+				printf("%d items: BVH found %d visible, testing every box found %d\n", count, (int)visible.size(), (int)linearVisible.size());
+				passed = false;
+			}
+
+			std::vector<ew::Ray> rays(NUM_RAYS);
+			for (int i = 0; i < NUM_RAYS; i++)
+			{
+				rays[i].origin = ew::Vec3(random.range(-halfSize, halfSize), random.range(-halfSize, halfSize), random.range(-halfSize, halfSize));
+				rays[i].direction = ew::Normalize(ew::Vec3(random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f)));
+			}
+			std::vector<float> distances(NUM_RAYS);
+			std::vector<int> hits(NUM_RAYS);
+			Timer rayTimer;
+			for (int i = 0; i < NUM_RAYS; i++)
+				hits[i] = bvh.raycast(rays[i], 1e30f, &distances[i]);
+			double rayUs = rayTimer.getMilliseconds() * 1000.0 / NUM_RAYS;
+			//Brute force rays get slow at 1M boxes, so only a tenth of them are checked
+			int numLinearRays = count >= 100000 ? NUM_RAYS / 10 : NUM_RAYS;
+			Timer linearRayTimer;
+			for (int i = 0; i < numLinearRays; i++)
+			{
+				float distance;
+				int hit = raycastBruteForce(boxes, rays[i], 1e30f, &distance);
+				//Ties may pick either box, but the distance must be the same
+				if ((hit < 0) != (hits[i] < 0) || (hit >= 0 && distance != distances[i])) {
+					printf("%d items: ray %d hit %d at %f, testing every box hit %d at %f\n", count, i, hits[i], distances[i], hit, distance);
+					passed = false;
+				}
+			}
+			double linearRayUs = linearRayTimer.getMilliseconds() * 1000.0 / numLinearRays;
+			printf("%8d %10.2f %10.2f %12.3f %12.3f %10d %14.2f %14.2f\n",
+				count, buildMs, refitMs, queryMs, linearMs, (int)visible.size(), rayUs, linearRayUs);
+		}
+		return passed;
+	}
+}
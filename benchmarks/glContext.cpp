@@ -0,0 +1,103 @@
+#include "glContext.h"
+#include <stdio.h>
+
+//With EGL (EW_BENCHMARKS_EGL, set by CMake when it finds it) the context needs neither a window nor a display
+//server, so the GL benchmarks also run headless, e.g. on Mesa's llvmpipe. Otherwise a hidden GLFW window is used.
+#if defined(EW_BENCHMARKS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+//After the EGL headers, which need their own khrplatform.h rather than glad's copy
+#include <ew/external/glad.h>
+#if !defined(EW_BENCHMARKS_EGL)
+#include <GLFW/glfw3.h>
+#endif
+
+namespace bench {
+	static bool s_created = false;
+	static bool s_valid = false;
+
+#if defined(EW_BENCHMARKS_EGL)
+	static EGLDisplay getDisplay() {
+		//Surfaceless needs no X or Wayland connection. Fall back to the default display where it isn't supported.
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL) {
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+				return display;
+		}
+		EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+			return display;
+		return EGL_NO_DISPLAY;
+	}
+
+	static bool createContext() {
+		EGLDisplay display = getDisplay();
+		if (display == EGL_NO_DISPLAY) {
+			printf("Failed to initialize EGL\n");
+			return false;
+		}
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			printf("EGL has no desktop OpenGL\n");
+			return false;
+		}
+		//EGL_SURFACE_TYPE defaults to windows, which a surfaceless display has none of
+		const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLConfig config;
+		EGLint numConfigs = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0) {
+			printf("No EGL config supports OpenGL\n");
+			return false;
+		}
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		if (context == EGL_NO_CONTEXT) {
+			printf("Failed to create an OpenGL 4.5 context with EGL\n");
+			return false;
+		}
+		if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			printf("Failed to make the EGL context current\n");
+			return false;
+		}
+		return gladLoadGL((GLADloadfunc)eglGetProcAddress) != 0;
+	}
+#else
+	static bool createContext() {
+		if (!glfwInit()) {
+			printf("GLFW failed to init\n");
+			return false;
+		}
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		GLFWwindow* window = glfwCreateWindow(1, 1, "ewBenchmarks", NULL, NULL);
+		if (window == NULL) {
+			printf("GLFW failed to create a window\n");
+			return false;
+		}
+		glfwMakeContextCurrent(window);
+		return gladLoadGL(glfwGetProcAddress) != 0;
+	}
+#endif
+
+	bool makeGLContextCurrent() {
+		if (!s_created) {
+			s_created = true;
+			s_valid = createContext();
+		}
+		return s_valid;
+	}
+
+	const char* getGLRenderer() {
+		if (!s_valid)
+			return "none";
+		return (const char*)glGetString(GL_RENDERER);
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace bench {
+	//Makes an offscreen OpenGL 4.5 core context current and loads GL through glad. The context is created
+	//on the first call and shared by every GL benchmark. There is no default framebuffer, render into an FBO.
+	//Returns false if no context could be created, e.g. on a machine without a GL driver.
+	bool makeGLContextCurrent();
+	//GL_RENDERER of the current context, so results can be told apart (e.g. "llvmpipe")
+	const char* getGLRenderer();
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "benchmark.h"
+#include "glContext.h"
+#include "ew/external/glad.h"
+#include "ew/camera.h"
+#include "ew/shader.h"
+#include "ew/mesh.h"
+#include "ew/procGen.h"
+#include "ew/transform.h"
+#include "ew/transformBatch.h"
+#include "ew/instanceBuffer.h"
+#include "ew/glStateCache.h"
+
+namespace bench {
+	static const int NUM_CUBES = 100000;
+	static const int NUM_FRAMES = 5;
+	//Small, so the software rasterizer's fill rate doesn't hide the CPU side
+	static const int TARGET_WIDTH = 320;
+	static const int TARGET_HEIGHT = 180;
+
+	struct FrameTimes {
+		double matricesMs = 1e30; //Building the model matrices, and for instancing copying them to the instance buffer
+		double cpuMs = 1e30; //Matrices plus submitting the draws, like assignment5's "CPU render time"
+		double frameMs = 1e30; //Until the GPU has finished the frame
+		int drawCalls = 0;
+	};
+
+	/// <summary>
+	/// Draws 100k cubes the way assignment5 does, once with one instanced draw and once with a draw per cube.
+	/// Both images are read back and compared, so the instanced path is checked against the per cube one.
+	/// Software renderers like llvmpipe shade vertices inside the draw call, so there the draw time is mostly
+	/// the same 2.4M vertices either way and the per draw overhead instancing removes is a small part of it.
+	/// </summary>
+	bool runInstancing() {
+		if (!makeGLContextCurrent()) {
+			printf("skipped: no GL context\n");
+			return true;
+		}
+		printf("renderer: %s\n", getGLRenderer());
+
+		const std::string assets = std::string(EW_BENCHMARKS_ASSIGNMENTS_DIR) + "assignment5_camera/assets/";
+		ew::Shader shader(assets + "vertexShader.vert", assets + "fragmentShader.frag");
+		ew::Shader instancedShader(assets + "vertexShader.vert", assets + "fragmentShader.frag", { "INSTANCED" });
+		ew::UniformHandle modelUniform = shader.getUniform("_Model");
+		ew::UniformHandle viewProjectionUniform = instancedShader.getUniform("_ViewProjection");
+		if (!modelUniform.isValid() || !viewProjectionUniform.isValid()) {
+			printf("Could not build the assignment5 shaders from %s\n", assets.c_str());
+			return false;
+		}
+
+		//No default framebuffer in an offscreen context
+		unsigned int fbo, colorBuffer, depthBuffer;
+		glGenFramebuffers(1, &fbo);
+		glGenRenderbuffers(1, &colorBuffer);
+		glGenRenderbuffers(1, &depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_WIDTH, TARGET_HEIGHT);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, TARGET_WIDTH, TARGET_HEIGHT);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		glViewport(0, 0, TARGET_WIDTH, TARGET_HEIGHT);
+		ew::getGLStateCache().invalidate();
+		ew::getGLStateCache().enable(GL_DEPTH_TEST);
+
+		//Square grid centered on the origin, as assignment5 lays them out, seen from far enough to fit
+		std::vector<ew::Transform> transforms(NUM_CUBES);
+		int gridSize = (int)ceilf(sqrtf((float)NUM_CUBES));
+		for (int i = 0; i < NUM_CUBES; i++)
+		{
+			transforms[i].position.x = i % gridSize - (gridSize - 1) * 0.5f;
+			transforms[i].position.y = i / gridSize - (gridSize - 1) * 0.5f;
+			transforms[i].rotation = ew::Vec3(30.0f, (float)(i % 360), 0.0f);
+		}
+		ew::Camera camera;
+		camera.position = ew::Vec3(0.0f, 0.0f, gridSize * 0.9f);
+		camera.farPlane = gridSize * 2.0f;
+		camera.aspectRatio = (float)TARGET_WIDTH / TARGET_HEIGHT;
+		ew::Mat4 viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+
+		ew::Mesh cubeMesh(ew::createCube(0.5f));
+		ew::InstanceBuffer instanceBuffer(NUM_CUBES);
+		ew::TransformStream transformStream;
+		std::vector<ew::Mat4> modelMatrices(NUM_CUBES);
+		std::vector<ew::InstanceData> instances(NUM_CUBES);
+
+		std::vector<unsigned char> images[2];
+		FrameTimes times[2];
+		for (int instanced = 1; instanced >= 0; instanced--)
+		{
+			FrameTimes& result = times[instanced];
+			//One untimed frame first, so shader variants and buffers the driver creates lazily exist
+			for (int frame = 0; frame <= NUM_FRAMES; frame++)
+			{
+				glClearColor(0.3f, 0.4f, 0.9f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glFinish();
+				Timer timer;
+				transformStream.load(transforms.data(), NUM_CUBES);
+				ew::computeModelMatrices(transformStream, modelMatrices.data());
+				if (instanced) {
+					for (int i = 0; i < NUM_CUBES; i++)
+						instances[i].model = modelMatrices[i];
+					instanceBuffer.upload(instances.data(), NUM_CUBES);
+				}
+				double matricesMs = timer.getMilliseconds();
+				if (instanced) {
+					instancedShader.use();
+					instancedShader.setMat4(viewProjectionUniform, viewProjection);
+					cubeMesh.drawInstanced(instanceBuffer);
+					result.drawCalls = 1;
+				}
+				else {
+					shader.use();
+					for (int i = 0; i < NUM_CUBES; i++)
+					{
+						shader.setMat4(modelUniform, viewProjection * modelMatrices[i]);
+						cubeMesh.draw();
+					}
+					result.drawCalls = NUM_CUBES;
+				}
+				double cpuMs = timer.getMilliseconds();
+				glFinish();
+				double frameMs = timer.getMilliseconds();
+				if (frame == 0)
+					continue;
+				result.matricesMs = std::min(result.matricesMs, matricesMs);
+				result.cpuMs = std::min(result.cpuMs, cpuMs);
+				result.frameMs = std::min(result.frameMs, frameMs);
+			}
+			images[instanced].resize(TARGET_WIDTH * TARGET_HEIGHT * 4);
+			glReadPixels(0, 0, TARGET_WIDTH, TARGET_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, images[instanced].data());
+		}
+		bool noErrors = glGetError() == GL_NO_ERROR;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+
+		//The per cube path multiplies viewProjection * model on the CPU, so edges may round to other pixels
+		int numPixels = TARGET_WIDTH * TARGET_HEIGHT;
+		int numDifferent = 0, numCovered = 0;
+		for (int i = 0; i < numPixels; i++)
+		{
+			const unsigned char* a = &images[0][i * 4];
+			const unsigned char* b = &images[1][i * 4];
+			numDifferent += (a[0] != b[0] || a[1] != b[1] || a[2] != b[2]) ? 1 : 0;
+			numCovered += (b[0] != images[1][0] || b[1] != images[1][1] || b[2] != images[1][2]) ? 1 : 0;
+		}
+		const char* names[2] = { "per cube", "instanced" };
+		for (int instanced = 1; instanced >= 0; instanced--)
+		{
+			printf("%d cubes  %-9s  %6d draw calls  CPU %8.2f ms (matrices %6.2f, draws %8.2f)  frame %8.2f ms (best of %d)\n",
+				NUM_CUBES, names[instanced], times[instanced].drawCalls, times[instanced].cpuMs, times[instanced].matricesMs,
+				times[instanced].cpuMs - times[instanced].matricesMs, times[instanced].frameMs, NUM_FRAMES);
+		}
+		printf("instanced is %.1fx faster on the CPU, %.1fx per frame\n", times[0].cpuMs / times[1].cpuMs, times[0].frameMs / times[1].frameMs);
+		printf("pixels covered: %d of %d, differing between the two: %d\n", numCovered, numPixels, numDifferent);
+		//Rounding only moves a few edge pixels, anything more means the paths disagree
+		return noErrors && numCovered > 0 && numDifferent <= numPixels / 100;
+	}
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include "benchmark.h"
+#include "ew/lightClusters.h"
+
+namespace bench {
+	static const int NUM_LIGHTS = 10000;
+	static const int NUM_RUNS = 10;
+
+	//Best of NUM_RUNS updates, in milliseconds
+	static double timeUpdate(ew::LightClusters& clusters, const ew::Camera& camera, const std::vector<ew::PointLight>& lights, int threadCount) {
+		double best = 1e30;
+		for (int run = 0; run < NUM_RUNS; run++)
+		{
+			Timer timer;
+			clusters.update(camera, lights.data(), (int)lights.size(), threadCount);
+			double ms = timer.getMilliseconds();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	/// <summary>
+	/// Bins 10k lights into the 16x9x24 grid assignment7 uses, on one thread and on every hardware thread.
+	/// The result is checked against testing every light against every cluster's bounds.
+	/// Never calls upload(), so no GL context is needed.
+	/// </summary>
+	bool runLightClusters() {
+		const int GRID_X = 16, GRID_Y = 9, GRID_Z = 24;
+		ew::Camera camera;
+		camera.position = ew::Vec3(0.0f, 2.0f, 10.0f);
+		camera.target = ew::Vec3(0.0f, 0.0f, 0.0f);
+		camera.nearPlane = 0.1f;
+		camera.farPlane = 100.0f;
+
+		//Lights scattered through and around the view volume
+		Random random(5678);
+		std::vector<ew::PointLight> lights(NUM_LIGHTS);
+		for (ew::PointLight& light : lights)
+		{
+			light.position = ew::Vec3(random.range(-50.0f, 50.0f), random.range(-25.0f, 25.0f), random.range(-90.0f, 10.0f));
+			light.radius = random.range(0.5f, 4.0f);
+		}
+
+		ew::LightClusters clusters(GRID_X, GRID_Y, GRID_Z);
+		int hardwareThreads = (int)std::thread::hardware_concurrency();
+		hardwareThreads = hardwareThreads > 1 ? hardwareThreads : 1;
+		double oneThreadMs = timeUpdate(clusters, camera, lights, 1);
+		double threadedMs = timeUpdate(clusters, camera, lights, hardwareThreads);
+
+		//Brute force: every light against every cluster's view space box
+		ew::Mat4 view = camera.ViewMatrix();
+		std::vector<ew::Vec3> viewPositions(NUM_LIGHTS);
+		for (int i = 0; i < NUM_LIGHTS; i++)
+			viewPositions[i] = (view * ew::Vec4(lights[i].position, 1.0f)).toVec3();
+		int numMismatches = 0;
+		std::vector<unsigned int> expected, binned;
+		Timer bruteForceTimer;
+		for (int z = 0; z < GRID_Z; z++)
+		{
+			for (int y = 0; y < GRID_Y; y++)
+			{
+				for (int x = 0; x < GRID_X; x++)
+				{
+					ew::AABB box = clusters.getClusterBounds(x, y, z);
+					expected.clear();
+					for (int i = 0; i < NUM_LIGHTS; i++)
+					{
+						const ew::Vec3& p = viewPositions[i];
+						float dx = std::max(box.min.x - p.x, 0.0f) + std::max(p.x - box.max.x, 0.0f);
+						float dy = std::max(box.min.y - p.y, 0.0f) + std::max(p.y - box.max.y, 0.0f);
+						float dz = std::max(box.min.z - p.z, 0.0f) + std::max(p.z - box.max.z, 0.0f);
+						if (dx * dx + dy * dy + dz * dz <= lights[i].radius * lights[i].radius)
+							expected.push_back((unsigned int)i);
+					}
+					const unsigned int* first = clusters.getClusterLights(x, y, z);
+					binned.assign(first, first + clusters.getClusterLightCount(x, y, z));
+					std::sort(binned.begin(), binned.end());
+					if (binned != expected) {
+						if (numMismatches == 0)
+							printf("Cluster (%d, %d, %d): binned %d lights, brute force found %d\n", x, y, z, (int)binned.size(), (int)expected.size());
+						numMismatches++;
+					}
+				}
+			}
+		}
+		double bruteForceMs = bruteForceTimer.getMilliseconds();
+
+		printf("%d lights, %dx%dx%d clusters, %d light indices, best of %d runs\n",
+			NUM_LIGHTS, GRID_X, GRID_Y, GRID_Z, clusters.getNumIndices(), NUM_RUNS);
+		printf("update: 1 thread %.3f ms, %d threads %.3f ms\n", oneThreadMs, hardwareThreads, threadedMs);
+		printf("brute force: %.3f ms, %d mismatched clusters\n", bruteForceMs, numMismatches);
+		return numMismatches == 0;
+	}
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+
+struct Benchmark {
+	const char* name;
+	bool(*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+	{ "mat4", bench::runMat4 },
+	{ "bvh", bench::runBVH },
+	{ "lightClusters", bench::runLightClusters },
+	{ "shaderCache", bench::runShaderCache },
+	{ "instancing", bench::runInstancing },
+};
+
+//Runs every benchmark, or only the ones named on the command line.
+//Exits with 1 if any cross-check failed.
+int main(int argc, char** argv) {
+	int numFailed = 0;
+	for (const Benchmark& benchmark : BENCHMARKS) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++)
+			selected |= strcmp(argv[i], benchmark.name) == 0;
+		if (!selected)
+			continue;
+		printf("== %s\n", benchmark.name);
+		if (!benchmark.run()) {
+			printf("%s: FAILED\n", benchmark.name);
+			numFailed++;
+		}
+	}
+	return numFailed > 0 ? 1 : 0;
+}
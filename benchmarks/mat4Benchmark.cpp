@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "benchmark.h"
+#include "ew/ewMath/ewMath.h"
+
+namespace bench {
+	static const int NUM_MATRICES = 100000;
+	static const int NUM_RUNS = 10;
+
+	//Same sums in the same order as Mat4's scalar path, so SIMD results must match them bit for bit
+	static ew::Mat4 multiplyReference(const ew::Mat4& l, const ew::Mat4& r) {
+		ew::Mat4 m;
+		for (int c = 0; c < 4; c++)
+		{
+			for (int row = 0; row < 4; row++)
+				m[c][row] = l.at(0, row) * r.at(c, 0) + l.at(1, row) * r.at(c, 1) + l.at(2, row) * r.at(c, 2) + l.at(3, row) * r.at(c, 3);
+		}
+		return m;
+	}
+	static ew::Vec4 multiplyReference(const ew::Mat4& m, const ew::Vec4& v) {
+		ew::Vec4 out;
+		for (int row = 0; row < 4; row++)
+			out[row] = m.at(0, row) * v.x + m.at(1, row) * v.y + m.at(2, row) * v.z + m.at(3, row) * v.w;
+		return out;
+	}
+
+	static ew::Mat4 randomMatrix(Random& random) {
+		ew::Mat4 m;
+		for (int c = 0; c < 4; c++)
+		{
+			for (int row = 0; row < 4; row++)
+				m[c][row] = random.range(-10.0f, 10.0f);
+		}
+		return m;
+	}
+
+	//Best of NUM_RUNS, in milliseconds
+	template<typename F>
+	static double timeBest(F batch) {
+		double best = 1e30;
+		for (int run = 0; run < NUM_RUNS; run++)
+		{
+			Timer timer;
+			batch();
+			double ms = timer.getMilliseconds();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	/// <summary>
+	/// Times Mat4 * Mat4 and Mat4 * Vec4 over batches of 100k with the backend this build was configured with
+	/// (EW_MATH_SIMD), against a plain scalar loop. Fails if any result differs in a single bit.
+	/// </summary>
+	bool runMat4() {
+#if defined(EW_MATH_AVX)
+		const char* backend = "AVX";
+#elif defined(EW_MATH_SSE)
+		const char* backend = "SSE";
+#else
+		const char* backend = "scalar";
+#endif
+		Random random(1234);
+		std::vector<ew::Mat4> left(NUM_MATRICES), right(NUM_MATRICES);
+		std::vector<ew::Vec4> vectors(NUM_MATRICES);
+		for (int i = 0; i < NUM_MATRICES; i++)
+		{
+			left[i] = randomMatrix(random);
+			right[i] = randomMatrix(random);
+			vectors[i] = ew::Vec4(random.range(-10.0f, 10.0f), random.range(-10.0f, 10.0f), random.range(-10.0f, 10.0f), random.range(-10.0f, 10.0f));
+		}
+
+		std::vector<ew::Mat4> products(NUM_MATRICES), referenceProducts(NUM_MATRICES);
+		std::vector<ew::Vec4> transformed(NUM_MATRICES), referenceTransformed(NUM_MATRICES);
+		double matReference = timeBest([&]() {
+			for (int i = 0; i < NUM_MATRICES; i++)
+				referenceProducts[i] = multiplyReference(left[i], right[i]);
+		});
+		double matBackend = timeBest([&]() {
+			for (int i = 0; i < NUM_MATRICES; i++)
+				products[i] = left[i] * right[i];
+		});
+		double vecReference = timeBest([&]() {
+			for (int i = 0; i < NUM_MATRICES; i++)
+				referenceTransformed[i] = multiplyReference(left[i], vectors[i]);
+		});
+		double vecBackend = timeBest([&]() {
+			for (int i = 0; i < NUM_MATRICES; i++)
+				transformed[i] = left[i] * vectors[i];
+		});
+
+		int matMismatches = 0, vecMismatches = 0;
+		for (int i = 0; i < NUM_MATRICES; i++)
+		{
+			matMismatches += memcmp(&products[i], &referenceProducts[i], sizeof(ew::Mat4)) != 0;
+			vecMismatches += memcmp(&transformed[i], &referenceTransformed[i], sizeof(ew::Vec4)) != 0;
+		}
+		printf("%d matrices, best of %d runs, backend %s\n", NUM_MATRICES, NUM_RUNS, backend);
+		printf("Mat4 * Mat4: scalar %.3f ms, %s %.3f ms (%.2fx), %d mismatches\n",
+			matReference, backend, matBackend, matReference / matBackend, matMismatches);
+		printf("Mat4 * Vec4: scalar %.3f ms, %s %.3f ms (%.2fx), %d mismatches\n",
+			vecReference, backend, vecBackend, vecReference / vecBackend, vecMismatches);
+		return matMismatches == 0 && vecMismatches == 0;
+	}
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+#include "glContext.h"
+#include "ew/programCache.h"
+#include "ew/shaderPreprocessor.h"
+#include "ew/external/glad.h"
+
+namespace bench {
+	struct ProgramSources {
+		std::string name;
+		ew::ShaderSource vertex;
+		ew::ShaderSource fragment;
+	};
+
+	//Creates every program through the cache and returns the total milliseconds. Programs that fail to link count as failures.
+	static double timeCreate(const std::vector<ProgramSources>& programs, int& numFailed) {
+		std::vector<unsigned int> ids;
+		Timer timer;
+		for (const ProgramSources& program : programs)
+			ids.push_back(ew::createShaderProgramCached(program.vertex.code.c_str(), program.fragment.code.c_str()));
+		double ms = timer.getMilliseconds();
+		for (unsigned int id : ids) {
+			int success = 0;
+			glGetProgramiv(id, GL_LINK_STATUS, &success);
+			numFailed += success ? 0 : 1;
+			glDeleteProgram(id);
+		}
+		return ms;
+	}
+
+	/// <summary>
+	/// Creates the finalProject's programs (all 8 defaultLit variants, skybox and unlit) with an empty program cache,
+	/// then again with every binary cached. Checks that every program links and the second pass hit the cache.
+	/// Mesa keeps its own shader cache, which makes the cold pass partly warm. Point MESA_SHADER_CACHE_DIR at an
+	/// empty directory for a truly cold run. MESA_SHADER_CACHE_DISABLE also turns off Mesa's program binary formats.
+	/// </summary>
+	bool runShaderCache() {
+		if (!makeGLContextCurrent()) {
+			printf("skipped: no GL context\n");
+			return true;
+		}
+		printf("renderer: %s\n", getGLRenderer());
+
+		const std::string assets = std::string(EW_BENCHMARKS_ASSIGNMENTS_DIR) + "finalProject/assets/";
+		const char* features[] = { "NORMAL_MAP", "SKYBOX_REFLECTION", "UV_SCROLL" };
+		std::vector<ProgramSources> programs;
+		for (int mask = 0; mask < 8; mask++) {
+			std::vector<std::string> defines;
+			std::string name = "defaultLit";
+			for (int i = 0; i < 3; i++) {
+				if (mask & (1 << i)) {
+					defines.push_back(features[i]);
+					name += std::string(" ") + features[i];
+				}
+			}
+			programs.push_back({ name, ew::preprocessShader(assets + "defaultLit.vert", defines), ew::preprocessShader(assets + "defaultLit.frag", defines) });
+		}
+		programs.push_back({ "skybox", ew::preprocessShader(assets + "skybox.vert"), ew::preprocessShader(assets + "skybox.frag") });
+		programs.push_back({ "unlit", ew::preprocessShader(assets + "unlit.vert"), ew::preprocessShader(assets + "unlit.frag") });
+		for (const ProgramSources& program : programs) {
+			if (!program.vertex.valid || !program.fragment.valid) {
+				printf("Could not read the sources of %s from %s\n", program.name.c_str(), assets.c_str());
+				return false;
+			}
+		}
+
+		std::string previousDirectory = ew::getProgramCacheDirectory();
+		ew::setProgramCacheDirectory("benchmarkShaderCache");
+		if (!ew::isProgramCacheEnabled()) {
+			int numFailed = 0;
+			double ms = timeCreate(programs, numFailed);
+			printf("driver has no program binary formats, %d programs compiled in %.1f ms\n", (int)programs.size(), ms);
+			ew::setProgramCacheDirectory(previousDirectory);
+			return numFailed == 0;
+		}
+
+		std::vector<uint64_t> keys;
+		for (const ProgramSources& program : programs) {
+			keys.push_back(ew::hashProgramSources(program.vertex.code.c_str(), program.fragment.code.c_str()));
+			ew::removeCachedProgram(keys.back());
+		}
+		int numFailed = 0;
+		double coldMs = timeCreate(programs, numFailed);
+		double warmMs = timeCreate(programs, numFailed);
+
+		int numMisses = 0;
+		for (uint64_t key : keys) {
+			unsigned int id = ew::loadCachedProgram(key);
+			numMisses += id == 0 ? 1 : 0;
+			glDeleteProgram(id);
+			ew::removeCachedProgram(key);
+		}
+		ew::setProgramCacheDirectory(previousDirectory);
+
+		int count = (int)programs.size();
+		printf("%d programs  cold (compile + store): %8.1f ms (%.2f ms each)\n", count, coldMs, coldMs / count);
+		printf("%d programs  warm (cached binary):   %8.1f ms (%.2f ms each)  %.1fx faster\n", count, warmMs, warmMs / count, coldMs / warmMs);
+		printf("link failures: %d, programs missing from the cache: %d\n", numFailed, numMisses);
+		return numFailed == 0 && numMisses == 0;
+	}
+}
@@ -40,56 +40,62 @@ namespace MyLib {
 		return textureID;
 	}
 
+    //Unit cube, 6 faces x 2 triangles, baked at compile time
+    static constexpr float SKYBOX_VERTICES[] = {
+        // Front face
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        // Back face
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        // Left face
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+
+        // Right face
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f, -1.0f,
+
+        // Top face
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        // Bottom face
+       -1.0f, -1.0f, -1.0f,
+       -1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+       -1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f,
+    };
+    static_assert(sizeof(SKYBOX_VERTICES) == 36 * 3 * sizeof(float), "Skybox needs 36 vertices");
+
     unsigned int generateSkyboxVAO(float scale) {
-        float skyboxVertices[] = {
-            // Front face
-            -scale,  scale, -scale,
-            -scale, -scale, -scale,
-             scale, -scale, -scale,
-             scale, -scale, -scale,
-             scale,  scale, -scale,
-            -scale,  scale, -scale,
-
-            // Back face
-            -scale, -scale,  scale,
-            -scale,  scale,  scale,
-             scale,  scale,  scale,
-             scale,  scale,  scale,
-             scale, -scale,  scale,
-            -scale, -scale,  scale,
-
-            // Left face
-            -scale, -scale, -scale,
-            -scale,  scale, -scale,
-            -scale,  scale,  scale,
-            -scale,  scale,  scale,
-            -scale, -scale,  scale,
-            -scale, -scale, -scale,
-
-            // Right face
-             scale, -scale, -scale,
-             scale,  scale, -scale,
-             scale,  scale,  scale,
-             scale,  scale,  scale,
-             scale, -scale,  scale,
-             scale, -scale, -scale,
-
-             // Top face
-            -scale,  scale, -scale,
-            -scale,  scale,  scale,
-             scale,  scale,  scale,
-             scale,  scale,  scale,
-             scale,  scale, -scale,
-            -scale,  scale, -scale,
-
-            // Bottom face
-           -scale, -scale, -scale,
-           -scale, -scale,  scale,
-            scale, -scale, -scale,
-            scale, -scale, -scale,
-           -scale, -scale,  scale,
-            scale, -scale,  scale,
-        };
+        float skyboxVertices[36 * 3];
+        for (int i = 0; i < 36 * 3; i++)
+            skyboxVertices[i] = SKYBOX_VERTICES[i] * scale;
 
         unsigned int skyboxVAO, skyboxVBO;
         glGenVertexArrays(1, &skyboxVAO);
@@ -0,0 +1,80 @@
+#pragma once
+#include <math.h>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	//Axis aligned bounding box
+	struct AABB {
+		ew::Vec3 min = ew::Vec3(0.0f);
+		ew::Vec3 max = ew::Vec3(0.0f);
+
+		inline ew::Vec3 center()const { return (min + max) * 0.5f; }
+		//Half size on each axis
+		inline ew::Vec3 extents()const { return (max - min) * 0.5f; }
+	};
+
+	struct BoundingSphere {
+		ew::Vec3 center = ew::Vec3(0.0f);
+		float radius = 0.0f;
+	};
+
+	struct Ray {
+		ew::Vec3 origin = ew::Vec3(0.0f);
+		ew::Vec3 direction = ew::Vec3(0.0f, 0.0f, -1.0f); //Unit length
+	};
+
+	//Smallest box containing count points that are strideBytes apart, e.g. &vertices[0].pos with sizeof(Vertex)
+	inline AABB ComputeAABB(const ew::Vec3* first, size_t count, size_t strideBytes = sizeof(ew::Vec3)) {
+		AABB box;
+		if (count == 0)
+			return box;
+		const char* src = reinterpret_cast<const char*>(first);
+		box.min = box.max = *first;
+		for (size_t i = 1; i < count; i++)
+		{
+			const ew::Vec3& p = *reinterpret_cast<const ew::Vec3*>(src + i * strideBytes);
+			box.min = ew::Vec3(fminf(box.min.x, p.x), fminf(box.min.y, p.y), fminf(box.min.z, p.z));
+			box.max = ew::Vec3(fmaxf(box.max.x, p.x), fmaxf(box.max.y, p.y), fmaxf(box.max.z, p.z));
+		}
+		return box;
+	}
+
+	//Box containing box after being transformed by m (Arvo's method).
+	//Tightly fits the 8 transformed corners without transforming each of them.
+	inline AABB TransformAABB(const ew::Mat4& m, const AABB& box) {
+		ew::Vec3 c = box.center();
+		ew::Vec3 e = box.extents();
+		ew::Vec3 center = ew::Vec3(
+			m.at(0, 0) * c.x + m.at(1, 0) * c.y + m.at(2, 0) * c.z + m.at(3, 0),
+			m.at(0, 1) * c.x + m.at(1, 1) * c.y + m.at(2, 1) * c.z + m.at(3, 1),
+			m.at(0, 2) * c.x + m.at(1, 2) * c.y + m.at(2, 2) * c.z + m.at(3, 2)
+		);
+		ew::Vec3 extents = ew::Vec3(
+			fabsf(m.at(0, 0)) * e.x + fabsf(m.at(1, 0)) * e.y + fabsf(m.at(2, 0)) * e.z,
+			fabsf(m.at(0, 1)) * e.x + fabsf(m.at(1, 1)) * e.y + fabsf(m.at(2, 1)) * e.z,
+			fabsf(m.at(0, 2)) * e.x + fabsf(m.at(1, 2)) * e.y + fabsf(m.at(2, 2)) * e.z
+		);
+		AABB out;
+		out.min = center - extents;
+		out.max = center + extents;
+		return out;
+	}
+
+	//Slab test. On a hit, outDistance is the distance along the ray to the box, or 0 if the origin is inside it.
+	//invDirection is 1 / ray.direction, precomputed by the caller when testing many boxes.
+	inline bool RayIntersects(const Ray& ray, const ew::Vec3& invDirection, const AABB& box, float maxDistance, float* outDistance) {
+		float t1 = (box.min.x - ray.origin.x) * invDirection.x;
+		float t2 = (box.max.x - ray.origin.x) * invDirection.x;
+		float tMin = fminf(t1, t2), tMax = fmaxf(t1, t2);
+		t1 = (box.min.y - ray.origin.y) * invDirection.y;
+		t2 = (box.max.y - ray.origin.y) * invDirection.y;
+		tMin = fmaxf(tMin, fminf(t1, t2)); tMax = fminf(tMax, fmaxf(t1, t2));
+		t1 = (box.min.z - ray.origin.z) * invDirection.z;
+		t2 = (box.max.z - ray.origin.z) * invDirection.z;
+		tMin = fmaxf(tMin, fminf(t1, t2)); tMax = fminf(tMax, fmaxf(t1, t2));
+		if (tMax < fmaxf(tMin, 0.0f) || tMin > maxDistance)
+			return false;
+		*outDistance = fmaxf(tMin, 0.0f);
+		return true;
+	}
+}
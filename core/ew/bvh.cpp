@@ -0,0 +1,371 @@
+#include "bvh.h"
+#include <math.h>
+#include <utility>
+
+namespace ew {
+	//Centroids are binned along the split axis instead of sorting every item
+	static const int SAH_BINS = 16;
+	//Leaves at or below this size are kept when splitting doesn't lower the SAH cost
+	static const int MAX_LEAF_ITEMS = 8;
+	//Relative cost of visiting a node vs testing an item
+	static const float TRAVERSAL_COST = 1.0f;
+
+	static inline AABB emptyAABB() {
+		AABB box;
+		box.min = ew::Vec3(INFINITY);
+		box.max = ew::Vec3(-INFINITY);
+		return box;
+	}
+
+	//Plain comparisons compile to single min/max instructions, unlike fminf/fmaxf which must handle NaN
+	static inline ew::Vec3 minVec(const ew::Vec3& a, const ew::Vec3& b) {
+		return ew::Vec3(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+	}
+
+	static inline ew::Vec3 maxVec(const ew::Vec3& a, const ew::Vec3& b) {
+		return ew::Vec3(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+	}
+
+	static inline void grow(AABB& box, const AABB& other) {
+		box.min = minVec(box.min, other.min);
+		box.max = maxVec(box.max, other.max);
+	}
+
+	static inline void grow(AABB& box, const ew::Vec3& p) {
+		box.min = minVec(box.min, p);
+		box.max = maxVec(box.max, p);
+	}
+
+	//Half the surface area, which is all the SAH needs
+	static inline float halfArea(const AABB& box) {
+		ew::Vec3 d = box.max - box.min;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	static inline float axisValue(const ew::Vec3& v, int axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	static inline bool equalAABB(const AABB& a, const AABB& b) {
+		return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z
+			&& a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+	}
+
+	//Item bounds and centroid kept together, so the build partitions one contiguous array
+	struct BuildItem {
+		AABB bounds;
+		ew::Vec3 centroid;
+		int item;
+	};
+
+	static inline int binIndex(float value, float axisMin, float scale) {
+		int b = (int)((value - axisMin) * scale);
+		return b < SAH_BINS - 1 ? b : SAH_BINS - 1;
+	}
+
+	/// <summary>
+	/// Builds the tree top down. Each node is split where the binned surface area heuristic is cheapest,
+	/// or kept as a leaf when that is cheaper (or it can't be split).
+	/// </summary>
+	/// <param name="itemBounds">World space bounds of each item</param>
+	/// <param name="count">Number of items</param>
+	void BVH::build(const AABB* itemBounds, int count)
+	{
+		m_itemBounds.assign(itemBounds, itemBounds + count);
+		m_itemOrder.resize(count);
+		m_itemLeaf.assign(count, 0);
+		m_nodes.clear();
+		m_parents.clear();
+		if (count == 0)
+			return;
+		m_nodes.reserve(2 * count);
+		m_parents.reserve(2 * count);
+
+		std::vector<BuildItem> items(count);
+		for (int i = 0; i < count; i++)
+		{
+			items[i].bounds = itemBounds[i];
+			items[i].centroid = itemBounds[i].center();
+			items[i].item = i;
+		}
+
+		Node root;
+		root.first = 0;
+		root.count = count;
+		m_nodes.push_back(root);
+		m_parents.push_back(-1);
+
+		//Explicit stack, unbalanced splits can get deeper than is safe to recurse
+		std::vector<int> stack;
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			int nodeIndex = stack.back();
+			stack.pop_back();
+			const int first = m_nodes[nodeIndex].first;
+			const int nodeCount = m_nodes[nodeIndex].count;
+			BuildItem* nodeItems = items.data() + first;
+
+			AABB bounds = emptyAABB();
+			AABB centroidBounds = emptyAABB();
+			for (int i = 0; i < nodeCount; i++)
+			{
+				grow(bounds, nodeItems[i].bounds);
+				grow(centroidBounds, nodeItems[i].centroid);
+			}
+			m_nodes[nodeIndex].bounds = bounds;
+
+			//Bin centroids on all three axes in one pass
+			float axisMin[3], scale[3];
+			AABB binBounds[3][SAH_BINS];
+			int binCounts[3][SAH_BINS] = {};
+			for (int axis = 0; axis < 3; axis++)
+			{
+				axisMin[axis] = axisValue(centroidBounds.min, axis);
+				float axisExtent = axisValue(centroidBounds.max, axis) - axisMin[axis];
+				scale[axis] = axisExtent > 0.0f ? SAH_BINS / axisExtent : 0.0f;
+				for (int b = 0; b < SAH_BINS; b++)
+					binBounds[axis][b] = emptyAABB();
+			}
+			for (int i = 0; i < nodeCount && nodeCount > 1; i++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					int b = binIndex(axisValue(nodeItems[i].centroid, axis), axisMin[axis], scale[axis]);
+					binCounts[axis][b]++;
+					grow(binBounds[axis][b], nodeItems[i].bounds);
+				}
+			}
+
+			//Find the cheapest bin boundary on any axis
+			int bestAxis = -1, bestSplit = 0;
+			float bestCost = INFINITY;
+			for (int axis = 0; axis < 3 && nodeCount > 1; axis++)
+			{
+				if (scale[axis] == 0.0f)
+					continue;
+				//Sweep from the right to get the cost of everything right of each boundary, then from the left
+				float rightArea[SAH_BINS];
+				int rightCount[SAH_BINS];
+				AABB sweep = emptyAABB();
+				int sweepCount = 0;
+				for (int b = SAH_BINS - 1; b > 0; b--)
+				{
+					grow(sweep, binBounds[axis][b]);
+					sweepCount += binCounts[axis][b];
+					rightArea[b] = halfArea(sweep);
+					rightCount[b] = sweepCount;
+				}
+				sweep = emptyAABB();
+				sweepCount = 0;
+				for (int b = 0; b < SAH_BINS - 1; b++)
+				{
+					grow(sweep, binBounds[axis][b]);
+					sweepCount += binCounts[axis][b];
+					if (sweepCount == 0 || rightCount[b + 1] == 0)
+						continue;
+					float cost = halfArea(sweep) * sweepCount + rightArea[b + 1] * rightCount[b + 1];
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = b + 1;
+					}
+				}
+			}
+
+			float leafCost = halfArea(bounds) * nodeCount;
+			bestCost = TRAVERSAL_COST * halfArea(bounds) + bestCost;
+			if (bestAxis < 0 || (bestCost >= leafCost && nodeCount <= MAX_LEAF_ITEMS)) {
+				for (int i = first; i < first + nodeCount; i++)
+				{
+					m_itemOrder[i] = items[i].item;
+					m_itemLeaf[items[i].item] = nodeIndex;
+				}
+				continue;
+			}
+
+			//Partition items in place around the chosen bin boundary
+			int left = 0, right = nodeCount - 1;
+			while (left <= right)
+			{
+				if (binIndex(axisValue(nodeItems[left].centroid, bestAxis), axisMin[bestAxis], scale[bestAxis]) < bestSplit) {
+					left++;
+				}
+				else {
+					BuildItem temp = nodeItems[left];
+					nodeItems[left] = nodeItems[right];
+					nodeItems[right] = temp;
+					right--;
+				}
+			}
+
+			int leftChild = (int)m_nodes.size();
+			Node leftNode, rightNode;
+			leftNode.first = first;
+			leftNode.count = left;
+			rightNode.first = first + left;
+			rightNode.count = nodeCount - left;
+			m_nodes.push_back(leftNode);
+			m_nodes.push_back(rightNode);
+			m_parents.push_back(nodeIndex);
+			m_parents.push_back(nodeIndex);
+			m_nodes[nodeIndex].first = leftChild;
+			m_nodes[nodeIndex].count = 0;
+			stack.push_back(leftChild);
+			stack.push_back(leftChild + 1);
+		}
+	}
+
+	/// <summary>
+	/// Recomputes one node's bounds from its items or children
+	/// </summary>
+	void BVH::refitNode(int node)
+	{
+		Node& n = m_nodes[node];
+		AABB bounds = emptyAABB();
+		if (n.count > 0) {
+			for (int i = n.first; i < n.first + n.count; i++)
+				grow(bounds, m_itemBounds[m_itemOrder[i]]);
+		}
+		else {
+			bounds = m_nodes[n.first].bounds;
+			grow(bounds, m_nodes[n.first + 1].bounds);
+		}
+		n.bounds = bounds;
+	}
+
+	void BVH::refit(const AABB* itemBounds)
+	{
+		m_itemBounds.assign(itemBounds, itemBounds + m_itemBounds.size());
+		//Children are always stored after their parent, so a reverse walk visits them first
+		for (int node = (int)m_nodes.size() - 1; node >= 0; node--)
+			refitNode(node);
+	}
+
+	/// <summary>
+	/// Refits the path from the item's leaf to the root, stopping early once a node's bounds don't change
+	/// </summary>
+	void BVH::setItemBounds(int item, const AABB& bounds)
+	{
+		m_itemBounds[item] = bounds;
+		for (int node = m_itemLeaf[item]; node >= 0; node = m_parents[node])
+		{
+			AABB previous = m_nodes[node].bounds;
+			refitNode(node);
+			if (equalAABB(previous, m_nodes[node].bounds))
+				break;
+		}
+	}
+
+	/// <summary>
+	/// Walks the tree, skipping nodes outside the frustum. Nodes fully inside are accepted without testing their children.
+	/// </summary>
+	/// <param name="frustum">Frustum from ExtractFrustum</param>
+	/// <param name="outItems">Visible item indices are appended, in no particular order</param>
+	void BVH::queryFrustum(const Frustum& frustum, std::vector<int>& outItems) const
+	{
+		if (m_nodes.empty())
+			return;
+		//Node index, and whether the node is already known to be fully inside
+		std::vector<std::pair<int, bool>> stack;
+		stack.push_back(std::make_pair(0, false));
+		while (!stack.empty())
+		{
+			int nodeIndex = stack.back().first;
+			bool inside = stack.back().second;
+			stack.pop_back();
+			const Node& node = m_nodes[nodeIndex];
+
+			if (!inside) {
+				ew::Vec3 c = node.bounds.center();
+				ew::Vec3 e = node.bounds.extents();
+				bool outside = false;
+				inside = true;
+				for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+				{
+					const Plane& plane = frustum.planes[p];
+					float d = ew::Dot(plane.normal, c) + plane.distance;
+					float r = fabsf(plane.normal.x) * e.x + fabsf(plane.normal.y) * e.y + fabsf(plane.normal.z) * e.z;
+					if (d + r < 0.0f) {
+						outside = true;
+						break;
+					}
+					if (d - r < 0.0f)
+						inside = false;
+				}
+				if (outside)
+					continue;
+			}
+
+			if (node.count > 0) {
+				for (int i = node.first; i < node.first + node.count; i++)
+				{
+					int item = m_itemOrder[i];
+					if (inside || Intersects(frustum, m_itemBounds[item]))
+						outItems.push_back(item);
+				}
+			}
+			else {
+				stack.push_back(std::make_pair(node.first, inside));
+				stack.push_back(std::make_pair(node.first + 1, inside));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Finds the closest item bounds hit by a ray, visiting the nearer child first so farther subtrees can be skipped
+	/// </summary>
+	/// <param name="ray">World space ray with a unit length direction, e.g. from Camera::ScreenPointToRay</param>
+	/// <param name="maxDistance">Hits farther than this are ignored</param>
+	/// <param name="outDistance">Optional, receives the distance to the hit</param>
+	/// <returns>Index of the hit item, or -1</returns>
+	int BVH::raycast(const Ray& ray, float maxDistance, float* outDistance) const
+	{
+		if (m_nodes.empty())
+			return -1;
+		ew::Vec3 invDirection = ew::Vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+		int hitItem = -1;
+		float closest = maxDistance;
+		float t;
+		std::vector<int> stack;
+		if (RayIntersects(ray, invDirection, m_nodes[0].bounds, closest, &t))
+			stack.push_back(0);
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			//A closer hit may have been found since this node was pushed
+			if (!RayIntersects(ray, invDirection, node.bounds, closest, &t))
+				continue;
+			if (node.count > 0) {
+				for (int i = node.first; i < node.first + node.count; i++)
+				{
+					int item = m_itemOrder[i];
+					if (RayIntersects(ray, invDirection, m_itemBounds[item], closest, &t) && (hitItem < 0 || t < closest)) {
+						closest = t;
+						hitItem = item;
+					}
+				}
+				continue;
+			}
+			float tLeft, tRight;
+			bool hitLeft = RayIntersects(ray, invDirection, m_nodes[node.first].bounds, closest, &tLeft);
+			bool hitRight = RayIntersects(ray, invDirection, m_nodes[node.first + 1].bounds, closest, &tRight);
+			//Push the farther child first so the nearer one is popped next
+			if (hitLeft && hitRight) {
+				bool leftFirst = tLeft <= tRight;
+				stack.push_back(leftFirst ? node.first + 1 : node.first);
+				stack.push_back(leftFirst ? node.first : node.first + 1);
+			}
+			else if (hitLeft) {
+				stack.push_back(node.first);
+			}
+			else if (hitRight) {
+				stack.push_back(node.first + 1);
+			}
+		}
+		if (hitItem >= 0 && outDistance)
+			*outDistance = closest;
+		return hitItem;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "bounds.h"
+#include "frustum.h"
+
+namespace ew {
+	//Bounding volume hierarchy over a set of items (e.g. mesh instances), each identified by its index
+	//into the bounds array passed to build(). Moving items are handled with setItemBounds()/refit(),
+	//which keep the tree shape, so rebuild once many items have moved far from where they started.
+	class BVH {
+	public:
+		//Surface area heuristic build over count world space boxes
+		void build(const AABB* itemBounds, int count);
+		//Recomputes every node's bounds bottom up from new item bounds, same count as build()
+		void refit(const AABB* itemBounds);
+		//Updates one item and the bounds of its ancestors
+		void setItemBounds(int item, const AABB& bounds);
+
+		inline int getNumItems()const { return (int)m_itemBounds.size(); }
+		inline int getNumNodes()const { return (int)m_nodes.size(); }
+		inline const AABB& getItemBounds(int item)const { return m_itemBounds[item]; }
+
+		//Appends every item whose bounds intersect the frustum to outItems
+		void queryFrustum(const Frustum& frustum, std::vector<int>& outItems)const;
+		//Closest item whose bounds the ray hits within maxDistance, or -1
+		int raycast(const Ray& ray, float maxDistance = 1e30f, float* outDistance = nullptr)const;
+	private:
+		struct Node {
+			AABB bounds;
+			int first = 0; //Leaf: first index into m_itemOrder. Interior: index of left child, right child follows it.
+			int count = 0; //Number of items, 0 for interior nodes
+		};
+		void refitNode(int node);
+
+		std::vector<Node> m_nodes;
+		std::vector<int> m_parents;
+		std::vector<int> m_itemOrder; //Item indices grouped by leaf
+		std::vector<int> m_itemLeaf;
+		std::vector<AABB> m_itemBounds;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "ewMath/transformations.h"
 #include "ewMath/ewMath.h"
+#include "bounds.h"
 namespace ew {
 
 	struct Camera {
@@ -26,6 +27,19 @@ namespace ew {
 				return ew::Perspective(ew::Radians(fov), aspectRatio, nearPlane, farPlane);
 			}
 		}
+		//World space ray through a screen position in pixels (origin top left), e.g. from glfwGetCursorPos.
+		//Starts on the near plane.
+		inline ew::Ray ScreenPointToRay(float x, float y, float screenWidth, float screenHeight)const {
+			float ndcX = 2.0f * x / screenWidth - 1.0f;
+			float ndcY = 1.0f - 2.0f * y / screenHeight;
+			ew::Mat4 invViewProjection = ew::Inverse(ProjectionMatrix() * ViewMatrix());
+			ew::Vec4 nearPoint = invViewProjection * ew::Vec4(ndcX, ndcY, -1.0f, 1.0f);
+			ew::Vec4 farPoint = invViewProjection * ew::Vec4(ndcX, ndcY, 1.0f, 1.0f);
+			ew::Ray ray;
+			ray.origin = nearPoint.toVec3() / nearPoint.w;
+			ray.direction = ew::Normalize(farPoint.toVec3() / farPoint.w - ray.origin);
+			return ray;
+		}
 	};
 
 }
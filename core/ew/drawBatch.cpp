@@ -0,0 +1,96 @@
+#include "drawBatch.h"
+#include "external/glad.h"
+
+namespace ew {
+	DrawBatch::DrawBatch(const GeometryArena* arena, int capacity)
+	{
+		create(arena, capacity);
+	}
+
+	void DrawBatch::create(const GeometryArena* arena, int capacity)
+	{
+		m_arena = arena;
+		clear();
+		allocate(capacity);
+	}
+
+	/// <summary>
+	/// Sizes the indirect and model buffers for capacity draws. The indirect buffer holds the element commands,
+	/// followed by the same draws as array commands for drawing points.
+	/// </summary>
+	void DrawBatch::allocate(int capacity)
+	{
+		if (m_indirectBuffer == 0) {
+			glGenBuffers(1, &m_indirectBuffer);
+			glGenBuffers(1, &m_modelBuffer);
+		}
+		m_capacity = capacity > 1 ? capacity : 1;
+		m_numUploaded = 0;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, (sizeof(DrawElementsIndirectCommand) + sizeof(DrawArraysIndirectCommand)) * m_capacity,
+			NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_modelBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ew::Mat4) * m_capacity, NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	int DrawBatch::add(const MeshHandle& mesh, const ew::Mat4& model)
+	{
+		DrawElementsIndirectCommand command;
+		command.count = (uint32_t)mesh.numIndices;
+		command.instanceCount = mesh.isValid() ? 1 : 0;
+		command.firstIndex = (uint32_t)mesh.firstIndex;
+		command.baseVertex = mesh.baseVertex;
+		command.baseInstance = 0;
+		m_commands.push_back(command);
+		//Points draw every vertex of the mesh instead of its indices
+		DrawArraysIndirectCommand pointCommand;
+		pointCommand.count = (uint32_t)mesh.numVertices;
+		pointCommand.instanceCount = command.instanceCount;
+		pointCommand.first = (uint32_t)mesh.baseVertex;
+		pointCommand.baseInstance = 0;
+		m_pointCommands.push_back(pointCommand);
+		m_models.push_back(model);
+		return (int)m_commands.size() - 1;
+	}
+
+	void DrawBatch::upload()
+	{
+		int count = getNumDraws();
+		if (count > m_capacity) {
+			int capacity = m_capacity * 2;
+			allocate(capacity > count ? capacity : count);
+		}
+		m_numUploaded = count;
+		if (count == 0)
+			return;
+		size_t elementsSize = sizeof(DrawElementsIndirectCommand) * m_capacity;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, (sizeof(DrawElementsIndirectCommand) + sizeof(DrawArraysIndirectCommand)) * m_capacity,
+			NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * count, m_commands.data());
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, elementsSize, sizeof(DrawArraysIndirectCommand) * count, m_pointCommands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_modelBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ew::Mat4) * m_capacity, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ew::Mat4) * count, m_models.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void DrawBatch::draw(DrawMode drawMode, unsigned int binding) const
+	{
+		if (m_numUploaded == 0)
+			return;
+		m_arena->bind();
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_modelBuffer);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		if (drawMode == DrawMode::TRIANGLES) {
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, m_numUploaded, 0);
+		}
+		else {
+			glMultiDrawArraysIndirect(GL_POINTS, (const void*)(sizeof(DrawElementsIndirectCommand) * m_capacity), m_numUploaded, 0);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
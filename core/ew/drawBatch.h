@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "ewMath/ewMath.h"
+#include "geometryArena.h"
+
+namespace ew {
+	//Shader storage binding of the per draw data, after the ones in lightBuffer.h
+	const unsigned int STORAGE_BINDING_DRAWS = 3;
+
+	//Layouts glMultiDraw*Indirect reads from the indirect buffer
+	struct DrawElementsIndirectCommand {
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+	struct DrawArraysIndirectCommand {
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t first;
+		uint32_t baseInstance;
+	};
+	static_assert(sizeof(DrawElementsIndirectCommand) == 20 && sizeof(DrawArraysIndirectCommand) == 16, "Indirect commands must be tightly packed");
+
+	//Draws any number of meshes from one GeometryArena with a single glMultiDrawElementsIndirect call.
+	//Model matrices go to a shader storage buffer the vertex shader indexes with gl_DrawIDARB, which GLSL 450
+	//gets from #extension GL_ARB_shader_draw_parameters : require (gl_DrawID in core GLSL 460):
+	//layout(std430) readonly buffer DrawBlock { mat4 _Models[]; };
+	//Everything in a batch shares the bound program and textures, so use one batch per material.
+	class DrawBatch {
+	public:
+		DrawBatch() {};
+		DrawBatch(const GeometryArena* arena, int capacity = 64);
+		void create(const GeometryArena* arena, int capacity = 64);
+
+		//Removes all draws, e.g. at the start of a frame
+		inline void clear() { m_commands.clear(); m_pointCommands.clear(); m_models.clear(); }
+		//Returns the draw's index, which is its gl_DrawIDARB
+		int add(const MeshHandle& mesh, const ew::Mat4& model);
+		inline void setModel(int index, const ew::Mat4& model) { m_models[index] = model; }
+		inline int getNumDraws()const { return (int)m_commands.size(); }
+
+		//Sends commands and model matrices to the GPU, growing the buffers if needed.
+		//Storage from the previous upload is orphaned, so this never waits on draws still reading it.
+		void upload();
+		//Binds the arena's VAO and the model matrices, then issues every draw in one call
+		void draw(DrawMode drawMode = DrawMode::TRIANGLES, unsigned int binding = STORAGE_BINDING_DRAWS)const;
+	private:
+		void allocate(int capacity);
+
+		const GeometryArena* m_arena = nullptr;
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<DrawArraysIndirectCommand> m_pointCommands;
+		std::vector<ew::Mat4> m_models;
+		unsigned int m_indirectBuffer = 0;
+		unsigned int m_modelBuffer = 0;
+		int m_capacity = 0;
+		int m_numUploaded = 0;
+	};
+}
@@ -6,75 +6,169 @@
 #include "vec4.h"
 #include <cstddef>
 
+//SIMD backend is chosen at build time with the EW_MATH_SIMD cache option (see core/CMakeLists.txt).
+//Every backend sums the products in the same order, so results are bit-identical to the scalar path.
+#if defined(EW_MATH_AVX)
+#include <immintrin.h>
+#ifndef EW_MATH_SSE
+#define EW_MATH_SSE
+#endif
+#elif defined(EW_MATH_SSE)
+#include <xmmintrin.h>
+#endif
+
+//Intrinsics cannot run in constant expressions, so with a SIMD backend the operators check whether they
+//are being constant evaluated and fall back to the scalar path. Compilers without that check lose constexpr.
+//EW_MATH_CONSTEXPR_MULTIPLY is defined whenever Mat4 * Mat4, Mat4 * Vec4 and Transpose are constexpr.
+//Clang version numbers differ between vendors (Apple clang 9 is not LLVM 9), so clang is asked directly.
+#if defined(EW_MATH_SSE)
+#if defined(__clang__) && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define EW_MATH_HAS_IS_CONSTANT_EVALUATED
+#endif
+#elif !defined(__clang__) && ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define EW_MATH_HAS_IS_CONSTANT_EVALUATED
+#endif
+#if defined(EW_MATH_HAS_IS_CONSTANT_EVALUATED)
+#define EW_MATH_SIMD_CONSTEXPR constexpr
+#define EW_MATH_USE_SIMD() (!__builtin_is_constant_evaluated())
+#define EW_MATH_CONSTEXPR_MULTIPLY
+#else
+#define EW_MATH_SIMD_CONSTEXPR
+#define EW_MATH_USE_SIMD() true
+#endif
+#else
+#define EW_MATH_CONSTEXPR_MULTIPLY
+#endif
+
 namespace ew {
 	struct Mat4 {
 	private:
 		float n[4][4];
 	public:
 		Mat4() = default;
-		Mat4(float n00)
-		{
-			n[0][0] = n00; n[1][0] = n00; n[2][0] = n00; n[3][0] = n00;
-			n[0][1] = n00; n[1][1] = n00; n[2][1] = n00; n[3][1] = n00;
-			n[0][2] = n00; n[1][2] = n00; n[2][2] = n00; n[3][2] = n00;
-			n[0][3] = n00; n[1][3] = n00; n[2][3] = n00; n[3][3] = n00;
-		};
-		Mat4(float n00, float n10, float n20, float n30,
+		constexpr Mat4(float n00)
+			:n{ { n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 } }
+		{};
+		constexpr Mat4(float n00, float n10, float n20, float n30,
 			 float n01, float n11, float n21, float n31,
 			 float n02, float n12, float n22, float n32,
 			 float n03, float n13, float n23, float n33)
-		{
-			n[0][0] = n00; n[1][0] = n10; n[2][0] = n20; n[3][0] = n30;
-			n[0][1] = n01; n[1][1] = n11; n[2][1] = n21; n[3][1] = n31;
-			n[0][2] = n02; n[1][2] = n12; n[2][2] = n22; n[3][2] = n32;
-			n[0][3] = n03; n[1][3] = n13; n[2][3] = n23; n[3][3] = n33;
-		};
-		Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d) {
-			n[0][0] = a.x; n[0][1] = a.y; n[0][2] = a.z; n[0][3] = a.w;
-			n[1][0] = b.x; n[1][1] = b.y; n[1][2] = b.z; n[1][3] = b.w;
-			n[2][0] = c.x; n[2][1] = c.y; n[2][2] = c.z; n[2][3] = c.w;
-			n[3][0] = d.x; n[3][1] = d.y; n[3][2] = d.z; n[3][3] = d.w;
-		}
+			:n{ { n00, n01, n02, n03 },
+				{ n10, n11, n12, n13 },
+				{ n20, n21, n22, n23 },
+				{ n30, n31, n32, n33 } }
+		{};
+		constexpr Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d)
+			:n{ { a.x, a.y, a.z, a.w },
+				{ b.x, b.y, b.z, b.w },
+				{ c.x, c.y, c.z, c.w },
+				{ d.x, d.y, d.z, d.w } }
+		{}
 		inline Vec4& operator[](int i) {
 			return (*reinterpret_cast<Vec4*>(n[i]));
 		}
 		inline const Vec4& operator[](int i) const{
 			return (*reinterpret_cast<const Vec4*>(n[i]));
 		}
-		inline friend Vec4 operator * (const Mat4& m, const Vec4& v) {
+		//Element at column c, row r. Unlike operator[], usable in constant expressions.
+		inline constexpr float at(int c, int r) const {
+			return n[c][r];
+		}
+#if defined(EW_MATH_SSE)
+		inline friend EW_MATH_SIMD_CONSTEXPR Vec4 operator * (const Mat4& m, const Vec4& v) {
+			if (EW_MATH_USE_SIMD())
+				return multiplySimd(m, v);
+			return multiplyScalar(m, v);
+		}
+		inline friend EW_MATH_SIMD_CONSTEXPR Mat4 operator * (const Mat4& l, const Mat4& r) {
+			if (EW_MATH_USE_SIMD())
+				return multiplySimd(l, r);
+			return multiplyScalar(l, r);
+		}
+#else
+		inline friend constexpr Vec4 operator * (const Mat4& m, const Vec4& v) {
+			return multiplyScalar(m, v);
+		}
+		inline friend constexpr Mat4 operator * (const Mat4& l, const Mat4& r) {
+			return multiplyScalar(l, r);
+		}
+#endif
+	private:
+		static inline constexpr Vec4 multiplyScalar(const Mat4& m, const Vec4& v) {
 			return Vec4(
-				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
-				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
-				m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * v.w,
-				m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
+				m.n[0][0] * v.x + m.n[1][0] * v.y + m.n[2][0] * v.z + m.n[3][0] * v.w,
+				m.n[0][1] * v.x + m.n[1][1] * v.y + m.n[2][1] * v.z + m.n[3][1] * v.w,
+				m.n[0][2] * v.x + m.n[1][2] * v.y + m.n[2][2] * v.z + m.n[3][2] * v.w,
+				m.n[0][3] * v.x + m.n[1][3] * v.y + m.n[2][3] * v.z + m.n[3][3] * v.w
+			);
+		}
+		//dot(l_row_r, r_col_c)
+		static inline constexpr float dotRowCol(const Mat4& l, int row, const Mat4& r, int col) {
+			return l.n[0][row] * r.n[col][0] + l.n[1][row] * r.n[col][1] + l.n[2][row] * r.n[col][2] + l.n[3][row] * r.n[col][3];
+		}
+		static inline constexpr Mat4 multiplyScalar(const Mat4& l, const Mat4& r) {
+			return Mat4(
+				dotRowCol(l, 0, r, 0), dotRowCol(l, 0, r, 1), dotRowCol(l, 0, r, 2), dotRowCol(l, 0, r, 3),
+				dotRowCol(l, 1, r, 0), dotRowCol(l, 1, r, 1), dotRowCol(l, 1, r, 2), dotRowCol(l, 1, r, 3),
+				dotRowCol(l, 2, r, 0), dotRowCol(l, 2, r, 1), dotRowCol(l, 2, r, 2), dotRowCol(l, 2, r, 3),
+				dotRowCol(l, 3, r, 0), dotRowCol(l, 3, r, 1), dotRowCol(l, 3, r, 2), dotRowCol(l, 3, r, 3)
 			);
 		}
-		inline friend Mat4 operator * (const Mat4& l, const Mat4& r) {
+#if defined(EW_MATH_SSE)
+		static inline Vec4 multiplySimd(const Mat4& m, const Vec4& v) {
+			//col0 * v.x + col1 * v.y + col2 * v.z + col3 * v.w
+			__m128 r = _mm_mul_ps(_mm_loadu_ps(m.n[0]), _mm_set1_ps(v.x));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[1]), _mm_set1_ps(v.y)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[2]), _mm_set1_ps(v.z)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[3]), _mm_set1_ps(v.w)));
+			Vec4 out;
+			_mm_storeu_ps(&out.x, r);
+			return out;
+		}
+#if defined(EW_MATH_AVX)
+		static inline Mat4 multiplySimd(const Mat4& l, const Mat4& r) {
+			//Each 256 bit register holds two result columns. Left columns are duplicated into both lanes
+			//and the matching right column entries are broadcast within each lane.
+			const __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[0]));
+			const __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[1]));
+			const __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[2]));
+			const __m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[3]));
+			Mat4 m;
+			for (int j = 0; j < 4; j += 2) {
+				const __m256 rc = _mm256_loadu_ps(r.n[j]);
+				__m256 c = _mm256_mul_ps(l0, _mm256_permute_ps(rc, _MM_SHUFFLE(0, 0, 0, 0)));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l1, _mm256_permute_ps(rc, _MM_SHUFFLE(1, 1, 1, 1))));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l2, _mm256_permute_ps(rc, _MM_SHUFFLE(2, 2, 2, 2))));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l3, _mm256_permute_ps(rc, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm256_storeu_ps(m.n[j], c);
+			}
+			return m;
+		}
+#else
+		static inline Mat4 multiplySimd(const Mat4& l, const Mat4& r) {
+			const __m128 l0 = _mm_loadu_ps(l.n[0]);
+			const __m128 l1 = _mm_loadu_ps(l.n[1]);
+			const __m128 l2 = _mm_loadu_ps(l.n[2]);
+			const __m128 l3 = _mm_loadu_ps(l.n[3]);
 			Mat4 m;
-			//Row 0
-			m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
-			m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
-			m[2][0] = l[0][0] * r[2][0] + l[1][0] * r[2][1] + l[2][0] * r[2][2] + l[3][0] * r[2][3];//dot(l_row_0,r_col_2)
-			m[3][0] = l[0][0] * r[3][0] + l[1][0] * r[3][1] + l[2][0] * r[3][2] + l[3][0] * r[3][3];//dot(l_row_0,r_col_3)
-			// Row 1		  		    		  		    		  		    		  
-			m[0][1] = l[0][1] * r[0][0] + l[1][1] * r[0][1] + l[2][1] * r[0][2] + l[3][1] * r[0][3];//dot(l_row_1,r_col_0)
-			m[1][1] = l[0][1] * r[1][0] + l[1][1] * r[1][1] + l[2][1] * r[1][2] + l[3][1] * r[1][3];//dot(l_row_1,r_col_1)
-			m[2][1] = l[0][1] * r[2][0] + l[1][1] * r[2][1] + l[2][1] * r[2][2] + l[3][1] * r[2][3];//dot(l_row_1,r_col_2)
-			m[3][1] = l[0][1] * r[3][0] + l[1][1] * r[3][1] + l[2][1] * r[3][2] + l[3][1] * r[3][3];//dot(l_row_1,r_col_3)
-			// Row  2		  		    		  		    		  		    		  
-			m[0][2] = l[0][2] * r[0][0] + l[1][2] * r[0][1] + l[2][2] * r[0][2] + l[3][2] * r[0][3];//dot(l_row_2,r_col_0)
-			m[1][2] = l[0][2] * r[1][0] + l[1][2] * r[1][1] + l[2][2] * r[1][2] + l[3][2] * r[1][3];//dot(l_row_2,r_col_1)
-			m[2][2] = l[0][2] * r[2][0] + l[1][2] * r[2][1] + l[2][2] * r[2][2] + l[3][2] * r[2][3];//dot(l_row_2,r_col_2)
-			m[3][2] = l[0][2] * r[3][0] + l[1][2] * r[3][1] + l[2][2] * r[3][2] + l[3][2] * r[3][3];//dot(l_row_2,r_col_3)
-			// Row  3		 			 		 			 		 			 		    
-			m[0][3] = l[0][3] * r[0][0] + l[1][3] * r[0][1] + l[2][3] * r[0][2] + l[3][3] * r[0][3];//dot(l_row_3,r_col_0)
-			m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
-			m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
-			m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
-			return m;		  
+			for (int j = 0; j < 4; j++) {
+				//Column j = l * r_col_j
+				__m128 c = _mm_mul_ps(l0, _mm_set1_ps(r.n[j][0]));
+				c = _mm_add_ps(c, _mm_mul_ps(l1, _mm_set1_ps(r.n[j][1])));
+				c = _mm_add_ps(c, _mm_mul_ps(l2, _mm_set1_ps(r.n[j][2])));
+				c = _mm_add_ps(c, _mm_mul_ps(l3, _mm_set1_ps(r.n[j][3])));
+				_mm_storeu_ps(m.n[j], c);
+			}
+			return m;
 		}
+#endif
+#endif
 	};
-	inline Mat4 IdentityMatrix() {
+	inline constexpr Mat4 IdentityMatrix() {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
@@ -0,0 +1,131 @@
+#pragma once
+#include <math.h>
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	//Rotation quaternion. w is the scalar part.
+	struct Quat {
+		float x, y, z, w;
+
+		constexpr Quat() :x(0), y(0), z(0), w(1) {};
+		constexpr Quat(float x, float y, float z, float w) :x(x), y(y), z(z), w(w) {};
+
+		friend constexpr Quat operator*(const Quat& a, const Quat& b);
+	};
+
+	//Hamilton product. Applies b first, then a.
+	inline constexpr Quat operator*(const Quat& a, const Quat& b) {
+		return Quat(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		);
+	}
+
+	inline constexpr float Dot(const Quat& a, const Quat& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	//Scales to unit length with a single reciprocal square root. q must not be zero.
+	inline Quat Normalize(const Quat& q) {
+		float invMag = 1.0f / sqrtf(Dot(q, q));
+		return Quat(q.x * invMag, q.y * invMag, q.z * invMag, q.w * invMag);
+	}
+
+	//Inverse of a unit quaternion
+	inline constexpr Quat Conjugate(const Quat& q) {
+		return Quat(-q.x, -q.y, -q.z, q.w);
+	}
+
+	//Rotation of rad radians around a unit length axis
+	inline Quat AxisAngle(const ew::Vec3& axis, float rad) {
+		float s = sinf(rad * 0.5f);
+		return Quat(axis.x * s, axis.y * s, axis.z * s, cosf(rad * 0.5f));
+	}
+
+	//Euler angles in radians, same order as Transform (RotateY * RotateX * RotateZ)
+	inline Quat FromEuler(const ew::Vec3& rad) {
+		float sx = sinf(rad.x * 0.5f), cx = cosf(rad.x * 0.5f);
+		float sy = sinf(rad.y * 0.5f), cy = cosf(rad.y * 0.5f);
+		float sz = sinf(rad.z * 0.5f), cz = cosf(rad.z * 0.5f);
+		return Quat(
+			cy * sx * cz + sy * cx * sz,
+			sy * cx * cz - cy * sx * sz,
+			cy * cx * sz - sy * sx * cz,
+			cy * cx * cz + sy * sx * sz
+		);
+	}
+
+	//Inverse of FromEuler. Returns radians.
+	inline ew::Vec3 ToEuler(const Quat& q) {
+		float sinX = 2.0f * (q.w * q.x - q.y * q.z);
+		sinX = sinX > 1.0f ? 1.0f : (sinX < -1.0f ? -1.0f : sinX);
+		return ew::Vec3(
+			asinf(sinX),
+			atan2f(2.0f * (q.x * q.z + q.w * q.y), 1.0f - 2.0f * (q.x * q.x + q.y * q.y)),
+			atan2f(2.0f * (q.x * q.y + q.w * q.z), 1.0f - 2.0f * (q.x * q.x + q.z * q.z))
+		);
+	}
+
+	inline constexpr ew::Vec3 Rotate(const Quat& q, const ew::Vec3& v) {
+		//v + 2w(u x v) + 2u x (u x v)
+		ew::Vec3 u = ew::Vec3(q.x, q.y, q.z);
+		ew::Vec3 t = ew::Cross(u, v) * 2.0f;
+		return v + t * q.w + ew::Cross(u, t);
+	}
+
+	//Normalized linear interpolation along the shortest arc. Cheap, but not constant angular velocity.
+	inline Quat Nlerp(const Quat& a, const Quat& b, float t) {
+		float sign = Dot(a, b) < 0.0f ? -1.0f : 1.0f;
+		float ta = 1.0f - t;
+		float tb = t * sign;
+		return Normalize(Quat(
+			a.x * ta + b.x * tb,
+			a.y * ta + b.y * tb,
+			a.z * ta + b.z * tb,
+			a.w * ta + b.w * tb
+		));
+	}
+
+	//Spherical linear interpolation along the shortest arc
+	inline Quat Slerp(const Quat& a, const Quat& b, float t) {
+		float cosTheta = Dot(a, b);
+		float sign = 1.0f;
+		if (cosTheta < 0.0f) {
+			cosTheta = -cosTheta;
+			sign = -1.0f;
+		}
+		//Nearly parallel, sin(theta) is too small to divide by
+		if (cosTheta > 0.9995f)
+			return Nlerp(a, b, t);
+		float theta = acosf(cosTheta);
+		float invSin = 1.0f / sinf(theta);
+		float ta = sinf((1.0f - t) * theta) * invSin;
+		float tb = sinf(t * theta) * invSin * sign;
+		return Quat(
+			a.x * ta + b.x * tb,
+			a.y * ta + b.y * tb,
+			a.z * ta + b.z * tb,
+			a.w * ta + b.w * tb
+		);
+	}
+
+	//Translate * Rotate * Scale built directly from a unit quaternion
+	inline constexpr ew::Mat4 TRS(const ew::Vec3& t, const Quat& q, const ew::Vec3& s) {
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		return ew::Mat4(
+			(1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy - wz) * s.y, 2.0f * (xz + wy) * s.z, t.x,
+			2.0f * (xy + wz) * s.x, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz - wx) * s.z, t.y,
+			2.0f * (xz - wy) * s.x, 2.0f * (yz + wx) * s.y, (1.0f - 2.0f * (xx + yy)) * s.z, t.z,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+
+	inline constexpr ew::Mat4 ToMat4(const Quat& q) {
+		return TRS(ew::Vec3(0.0f), q, ew::Vec3(1.0f));
+	}
+}
@@ -8,16 +8,11 @@
 
 namespace ew {
 	//Identity matrix
-	inline ew::Mat4 Identity() {
-		return ew::Mat4(
-			1, 0, 0, 0,
-			0, 1, 0, 0,
-			0, 0, 1, 0,
-			0, 0, 0, 1
-		);
+	inline constexpr ew::Mat4 Identity() {
+		return ew::IdentityMatrix();
 	};
 	//Scale on x,y,z axes
-	inline ew::Mat4 Scale(const ew::Vec3& s) {
+	inline constexpr ew::Mat4 Scale(const ew::Vec3& s) {
 		return ew::Mat4(
 			s.x, 0, 0, 0,
 			0, s.y, 0, 0,
@@ -59,7 +54,7 @@ namespace ew {
 		);
 	};
 	//Translate x,y,z
-	inline ew::Mat4 Translate(const ew::Vec3& t) {
+	inline constexpr ew::Mat4 Translate(const ew::Vec3& t) {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, t.x,
 			0.0f, 1.0f, 0.0f, t.y,
@@ -68,6 +63,111 @@ namespace ew {
 		);
 	};
 
+	//Scalar and SIMD implementations of Transpose, prefer calling Transpose
+	inline constexpr ew::Mat4 TransposeScalar(const ew::Mat4& m) {
+		return ew::Mat4(
+			m.at(0, 0), m.at(0, 1), m.at(0, 2), m.at(0, 3),
+			m.at(1, 0), m.at(1, 1), m.at(1, 2), m.at(1, 3),
+			m.at(2, 0), m.at(2, 1), m.at(2, 2), m.at(2, 3),
+			m.at(3, 0), m.at(3, 1), m.at(3, 2), m.at(3, 3)
+		);
+	};
+#if defined(EW_MATH_SSE)
+	inline ew::Mat4 TransposeSimd(const ew::Mat4& m) {
+		ew::Mat4 t;
+		__m128 c0 = _mm_loadu_ps(&m[0][0]);
+		__m128 c1 = _mm_loadu_ps(&m[1][0]);
+		__m128 c2 = _mm_loadu_ps(&m[2][0]);
+		__m128 c3 = _mm_loadu_ps(&m[3][0]);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(&t[0][0], c0);
+		_mm_storeu_ps(&t[1][0], c1);
+		_mm_storeu_ps(&t[2][0], c2);
+		_mm_storeu_ps(&t[3][0], c3);
+		return t;
+	};
+	//Swaps rows and columns
+	inline EW_MATH_SIMD_CONSTEXPR ew::Mat4 Transpose(const ew::Mat4& m) {
+		if (EW_MATH_USE_SIMD())
+			return TransposeSimd(m);
+		return TransposeScalar(m);
+	};
+#else
+	//Swaps rows and columns
+	inline constexpr ew::Mat4 Transpose(const ew::Mat4& m) {
+		return TransposeScalar(m);
+	};
+#endif
+	//General 4x4 inverse using cofactors. Returns a zero matrix if m is singular.
+	inline ew::Mat4 Inverse(const ew::Mat4& m) {
+		const float* a = &m[0][0];
+		float inv[16];
+		inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+		float invDet = det == 0.0f ? 0.0f : 1.0f / det;
+		ew::Mat4 r;
+		for (int c = 0; c < 4; c++)
+			for (int i = 0; i < 4; i++)
+				r[c][i] = inv[c * 4 + i] * invDet;
+		return r;
+	};
+	//Inverse of a matrix whose bottom row is (0,0,0,1), e.g. any model or view matrix. Much cheaper than Inverse.
+	inline constexpr ew::Mat4 AffineInverse(const ew::Mat4& m) {
+		ew::Vec3 c0 = ew::Vec3(m.at(0, 0), m.at(0, 1), m.at(0, 2));
+		ew::Vec3 c1 = ew::Vec3(m.at(1, 0), m.at(1, 1), m.at(1, 2));
+		ew::Vec3 c2 = ew::Vec3(m.at(2, 0), m.at(2, 1), m.at(2, 2));
+		ew::Vec3 t = ew::Vec3(m.at(3, 0), m.at(3, 1), m.at(3, 2));
+		//Rows of the 3x3 inverse are the cross products of the columns, divided by the determinant
+		ew::Vec3 r0 = ew::Cross(c1, c2);
+		ew::Vec3 r1 = ew::Cross(c2, c0);
+		ew::Vec3 r2 = ew::Cross(c0, c1);
+		float det = ew::Dot(c0, r0);
+		float invDet = det == 0.0f ? 0.0f : 1.0f / det;
+		r0 *= invDet;
+		r1 *= invDet;
+		r2 *= invDet;
+		return ew::Mat4(
+			r0.x, r0.y, r0.z, -ew::Dot(r0, t),
+			r1.x, r1.y, r1.z, -ew::Dot(r1, t),
+			r2.x, r2.y, r2.z, -ew::Dot(r2, t),
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	};
+	//transpose(inverse(mat3(model))) in the upper 3x3, for transforming normals. Only the upper 3x3 is used.
+	inline constexpr ew::Mat4 NormalMatrix(const ew::Mat4& model) {
+		ew::Vec3 c0 = ew::Vec3(model.at(0, 0), model.at(0, 1), model.at(0, 2));
+		ew::Vec3 c1 = ew::Vec3(model.at(1, 0), model.at(1, 1), model.at(1, 2));
+		ew::Vec3 c2 = ew::Vec3(model.at(2, 0), model.at(2, 1), model.at(2, 2));
+		//Columns of the inverse transpose are the cross products of the columns, divided by the determinant
+		ew::Vec3 n0 = ew::Cross(c1, c2);
+		ew::Vec3 n1 = ew::Cross(c2, c0);
+		ew::Vec3 n2 = ew::Cross(c0, c1);
+		float det = ew::Dot(c0, n0);
+		float invDet = det == 0.0f ? 0.0f : 1.0f / det;
+		return ew::Mat4(
+			n0.x * invDet, n1.x * invDet, n2.x * invDet, 0.0f,
+			n0.y * invDet, n1.y * invDet, n2.y * invDet, 0.0f,
+			n0.z * invDet, n1.z * invDet, n2.z * invDet, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	};
+
 	inline ew::Mat4 LookAt(const ew::Vec3& eyePos, const ew::Vec3& targetPos, const ew::Vec3& up) {
 		ew::Vec3 f = ew::Normalize(eyePos - targetPos);
 		ew::Vec3 r = ew::Normalize(ew::Cross(up, f));
@@ -91,21 +191,27 @@ namespace ew {
 		return m;
 	}
 
-	inline ew::Mat4 Orthographic(float height, float a, float n, float f) {
+	inline constexpr ew::Mat4 Orthographic(float height, float a, float n, float f) {
 		//Symmetrical bounds based on aspect ratio
 		float t = height / 2;
 		float b = -t;
 		float r = (height * a) / 2;
 		float l = -r;
 
-		Mat4 m = Mat4(0);
-		m[0][0] = 2 / (r - l);
-		m[1][1] = 2 / (t - b);
-		m[2][2] = -2 / (f - n);
-		m[3][0] = -(r + l) / (r - l);
-		m[3][1] = -(t + b) / (t - b);
-		m[3][2] = -(f + n) / (f - n);
-		m[3][3] = 1.0f;
-		return m;
+		return Mat4(
+			2 / (r - l), 0.0f, 0.0f, -(r + l) / (r - l),
+			0.0f, 2 / (t - b), 0.0f, -(t + b) / (t - b),
+			0.0f, 0.0f, -2 / (f - n), -(f + n) / (f - n),
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
 	}
+
+	//Compile-time checks
+	static_assert(ew::Translate(ew::Vec3(1, 2, 3)).at(3, 1) == 2.0f, "Translation lives in column 3");
+#if defined(EW_MATH_CONSTEXPR_MULTIPLY)
+	static_assert((ew::Translate(ew::Vec3(1, 2, 3)) * ew::Scale(ew::Vec3(2))).at(0, 0) == 2.0f, "Mat4 * Mat4 must be constexpr");
+	static_assert((ew::Scale(ew::Vec3(2)) * ew::Vec4(1, 2, 3, 1)).z == 6.0f, "Mat4 * Vec4 must be constexpr");
+	static_assert(ew::Transpose(ew::Translate(ew::Vec3(1, 2, 3))).at(0, 3) == 1.0f, "Transpose must be constexpr");
+#endif
+	static_assert(ew::AffineInverse(ew::Translate(ew::Vec3(1, 2, 3))).at(3, 2) == -3.0f, "AffineInverse must be constexpr");
 }
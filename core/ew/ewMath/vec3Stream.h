@@ -0,0 +1,158 @@
+#pragma once
+#include <vector>
+#include <math.h>
+#include <assert.h>
+#include "vec3.h"
+#include "mat4.h"
+
+#if defined(EW_MATH_SSE)
+#include <xmmintrin.h>
+#endif
+
+//Lets the compiler assume stream arrays do not alias, so the kernel loops auto-vectorize.
+//Compilers only honor it on function parameters, which is why each kernel takes raw pointers.
+#define EW_RESTRICT __restrict
+
+namespace ew {
+	//Structure of arrays of Vec3, for running the same operation over many vectors at once.
+	//Kernels that write to an output stream require it to be a different stream from the inputs.
+	struct Vec3Stream {
+		std::vector<float> x, y, z;
+
+		inline size_t size()const { return x.size(); }
+		inline void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); }
+		inline ew::Vec3 get(size_t i)const { return ew::Vec3(x[i], y[i], z[i]); }
+		inline void set(size_t i, const ew::Vec3& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+
+		//Copies count Vec3s that are strideBytes apart, e.g. &vertices[0].normal with sizeof(Vertex)
+		inline void load(const ew::Vec3* first, size_t count, size_t strideBytes = sizeof(ew::Vec3)) {
+			resize(count);
+			const char* src = reinterpret_cast<const char*>(first);
+			for (size_t i = 0; i < count; i++)
+			{
+				const ew::Vec3& v = *reinterpret_cast<const ew::Vec3*>(src + i * strideBytes);
+				x[i] = v.x; y[i] = v.y; z[i] = v.z;
+			}
+		}
+		//Writes the stream back out with the same layout load() accepts
+		inline void store(ew::Vec3* first, size_t strideBytes = sizeof(ew::Vec3))const {
+			char* dst = reinterpret_cast<char*>(first);
+			for (size_t i = 0; i < size(); i++)
+			{
+				ew::Vec3& v = *reinterpret_cast<ew::Vec3*>(dst + i * strideBytes);
+				v.x = x[i]; v.y = y[i]; v.z = z[i];
+			}
+		}
+	};
+
+	//Raw SoA kernels behind the Vec3Stream functions below
+	namespace streamKernels {
+		inline void dot(size_t count, const float* EW_RESTRICT ax, const float* EW_RESTRICT ay, const float* EW_RESTRICT az,
+			const float* EW_RESTRICT bx, const float* EW_RESTRICT by, const float* EW_RESTRICT bz, float* EW_RESTRICT out) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+		}
+		inline void cross(size_t count, const float* EW_RESTRICT ax, const float* EW_RESTRICT ay, const float* EW_RESTRICT az,
+			const float* EW_RESTRICT bx, const float* EW_RESTRICT by, const float* EW_RESTRICT bz,
+			float* EW_RESTRICT ox, float* EW_RESTRICT oy, float* EW_RESTRICT oz) {
+			for (size_t i = 0; i < count; i++)
+			{
+				ox[i] = ay[i] * bz[i] - az[i] * by[i];
+				oy[i] = az[i] * bx[i] - ax[i] * bz[i];
+				oz[i] = ax[i] * by[i] - ay[i] * bx[i];
+			}
+		}
+		inline void normalize(size_t count, float* EW_RESTRICT x, float* EW_RESTRICT y, float* EW_RESTRICT z) {
+			size_t i = 0;
+#if defined(EW_MATH_SSE)
+			//sqrtf may set errno, which stops compilers vectorizing the scalar loop, so do it by hand
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+				__m128 magSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+				__m128 nonZero = _mm_cmpgt_ps(magSq, zero);
+				__m128 invMag = _mm_div_ps(one, _mm_sqrt_ps(magSq));
+				invMag = _mm_or_ps(_mm_and_ps(nonZero, invMag), _mm_andnot_ps(nonZero, one));
+				_mm_storeu_ps(x + i, _mm_mul_ps(vx, invMag));
+				_mm_storeu_ps(y + i, _mm_mul_ps(vy, invMag));
+				_mm_storeu_ps(z + i, _mm_mul_ps(vz, invMag));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				float magSq = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+				float invMag = magSq > 0.0f ? 1.0f / sqrtf(magSq) : 1.0f;
+				x[i] *= invMag;
+				y[i] *= invMag;
+				z[i] *= invMag;
+			}
+		}
+		inline void lerp(size_t count, const float* EW_RESTRICT a, const float* EW_RESTRICT b, float t, float* EW_RESTRICT out) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = a[i] + (b[i] - a[i]) * t;
+		}
+		//Row of an affine transform: out = r0 * x + r1 * y + r2 * z + r3
+		inline void transformRow(size_t count, float r0, float r1, float r2, float r3,
+			const float* EW_RESTRICT x, const float* EW_RESTRICT y, const float* EW_RESTRICT z, float* EW_RESTRICT out) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = r0 * x[i] + r1 * y[i] + r2 * z[i] + r3;
+		}
+	}
+
+	//Number of elements a kernel over a and b can process. Both streams should be the same size,
+	//release builds only process the shorter one's elements.
+	inline size_t PairedSize(const Vec3Stream& a, const Vec3Stream& b) {
+		assert(a.size() == b.size());
+		return a.size() < b.size() ? a.size() : b.size();
+	}
+
+	//outDots[i] = Dot(a[i], b[i])
+	inline void Dot(const Vec3Stream& a, const Vec3Stream& b, float* outDots) {
+		streamKernels::dot(PairedSize(a, b), a.x.data(), a.y.data(), a.z.data(), b.x.data(), b.y.data(), b.z.data(), outDots);
+	}
+
+	//out[i] = Cross(a[i], b[i])
+	inline void Cross(const Vec3Stream& a, const Vec3Stream& b, Vec3Stream& out) {
+		size_t count = PairedSize(a, b);
+		out.resize(count);
+		streamKernels::cross(count, a.x.data(), a.y.data(), a.z.data(), b.x.data(), b.y.data(), b.z.data(),
+			out.x.data(), out.y.data(), out.z.data());
+	}
+
+	//Normalizes every vector in place. Zero length vectors are left unchanged, like Normalize(Vec3).
+	inline void Normalize(Vec3Stream& v) {
+		streamKernels::normalize(v.size(), v.x.data(), v.y.data(), v.z.data());
+	}
+
+	//out[i] = a[i] + (b[i] - a[i]) * t
+	inline void Lerp(const Vec3Stream& a, const Vec3Stream& b, float t, Vec3Stream& out) {
+		size_t count = PairedSize(a, b);
+		out.resize(count);
+		streamKernels::lerp(count, a.x.data(), b.x.data(), t, out.x.data());
+		streamKernels::lerp(count, a.y.data(), b.y.data(), t, out.y.data());
+		streamKernels::lerp(count, a.z.data(), b.z.data(), t, out.z.data());
+	}
+
+	//out[i] = (m * Vec4(v[i], w)).xyz. Prefer TransformPoints/TransformDirections.
+	inline void TransformVec3s(const ew::Mat4& m, const Vec3Stream& v, float w, Vec3Stream& out) {
+		out.resize(v.size());
+		for (int r = 0; r < 3; r++)
+		{
+			float* dst = r == 0 ? out.x.data() : (r == 1 ? out.y.data() : out.z.data());
+			streamKernels::transformRow(v.size(), m.at(0, r), m.at(1, r), m.at(2, r), m.at(3, r) * w,
+				v.x.data(), v.y.data(), v.z.data(), dst);
+		}
+	}
+
+	//out[i] = m * v[i] with w = 1
+	inline void TransformPoints(const ew::Mat4& m, const Vec3Stream& v, Vec3Stream& out) {
+		TransformVec3s(m, v, 1.0f, out);
+	}
+
+	//out[i] = m * v[i] with w = 0, ignoring translation
+	inline void TransformDirections(const ew::Mat4& m, const Vec3Stream& v, Vec3Stream& out) {
+		TransformVec3s(m, v, 0.0f, out);
+	}
+}
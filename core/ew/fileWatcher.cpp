@@ -0,0 +1,102 @@
+#include "fileWatcher.h"
+#include <stdio.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace ew {
+	static long long modifiedTime(const std::string& filePath) {
+		struct stat info;
+		if (stat(filePath.c_str(), &info) != 0)
+			return -1;
+		return (long long)info.st_mtime;
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+#if defined(__linux__)
+		//Closing the descriptor also removes every watch added to it
+		if (m_inotify >= 0)
+			close(m_inotify);
+#endif
+	}
+
+	void FileWatcher::watch(const std::string& filePath)
+	{
+		if (isWatching(filePath))
+			return;
+		m_files[filePath] = modifiedTime(filePath);
+#if defined(__linux__)
+		if (m_inotify == -1) {
+			m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (m_inotify < 0) {
+				printf("FileWatcher: inotify unavailable, falling back to polling\n");
+				m_inotify = -2;
+			}
+		}
+		if (m_inotify < 0)
+			return;
+		size_t slash = filePath.find_last_of('/');
+		std::string prefix = slash == std::string::npos ? std::string() : filePath.substr(0, slash + 1);
+		//Adding a directory that is already watched returns its existing descriptor
+		int wd = inotify_add_watch(m_inotify, prefix.empty() ? "." : prefix.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0)
+			printf("FileWatcher: failed to watch %s\n", prefix.c_str());
+		else
+			m_directories[wd] = prefix;
+#endif
+	}
+
+	static void appendUnique(std::vector<std::string>& list, const std::string& value) {
+		for (size_t i = 0; i < list.size(); i++)
+		{
+			if (list[i] == value)
+				return;
+		}
+		list.push_back(value);
+	}
+
+	/// <summary>
+	/// Drains pending inotify events. The descriptor is non-blocking, so this returns as soon as there are none.
+	/// </summary>
+	void FileWatcher::poll(std::vector<std::string>& outChanged)
+	{
+#if defined(__linux__)
+		if (m_inotify >= 0) {
+			//Big enough for many events, aligned for inotify_event
+			alignas(struct inotify_event) char buffer[4096];
+			while (true)
+			{
+				ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+				if (length <= 0)
+					break;
+				for (ssize_t offset = 0; offset < length;)
+				{
+					const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+					offset += sizeof(struct inotify_event) + event->len;
+					auto directory = m_directories.find(event->wd);
+					if (event->len == 0 || directory == m_directories.end())
+						continue;
+					std::string filePath = directory->second + event->name;
+					if (isWatching(filePath))
+						appendUnique(outChanged, filePath);
+				}
+			}
+			return;
+		}
+#endif
+		for (auto it = m_files.begin(); it != m_files.end(); ++it)
+		{
+			long long time = modifiedTime(it->first);
+			if (time == it->second)
+				continue;
+			it->second = time;
+			//Mid save the file may briefly not exist, report it once it is back
+			if (time >= 0)
+				appendUnique(outChanged, it->first);
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ew {
+	//Reports files that changed on disk, without ever blocking. On Linux it uses inotify on the files' directories,
+	//which also catches editors that save by writing a new file and renaming it over the old one.
+	//Elsewhere it compares modification times on each poll.
+	class FileWatcher {
+	public:
+		FileWatcher() {};
+		//Owns the inotify descriptor, so it can't be copied
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+		~FileWatcher();
+		//Watching the same file twice is a no-op
+		void watch(const std::string& filePath);
+		//Appends files changed since the last poll to outChanged, each at most once
+		void poll(std::vector<std::string>& outChanged);
+		inline bool isWatching(const std::string& filePath)const { return m_files.count(filePath) != 0; }
+	private:
+		std::unordered_map<std::string, long long> m_files; //Path to last modification time
+#if defined(__linux__)
+		int m_inotify = -1; //-2 if inotify failed to start
+		std::unordered_map<int, std::string> m_directories; //inotify watch descriptor to directory prefix
+#endif
+	};
+}
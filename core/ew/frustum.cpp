@@ -0,0 +1,184 @@
+#include "frustum.h"
+#include <math.h>
+#if defined(EW_MATH_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace ew {
+	/// <summary>
+	/// Plane a*x + b*y + c*z + d = 0, scaled so its normal is unit length
+	/// </summary>
+	static Plane makePlane(float a, float b, float c, float d) {
+		float invMag = 1.0f / sqrtf(a * a + b * b + c * c);
+		Plane plane;
+		plane.normal = ew::Vec3(a * invMag, b * invMag, c * invMag);
+		plane.distance = d * invMag;
+		return plane;
+	}
+
+	/// <summary>
+	/// Gribb-Hartmann plane extraction. A point is inside clip space when -w <= x,y,z <= w,
+	/// so each plane is the last row of the matrix plus or minus one of the other rows.
+	/// </summary>
+	/// <param name="viewProjection">Projection * View</param>
+	/// <returns>Frustum in world space</returns>
+	Frustum ExtractFrustum(const ew::Mat4& viewProjection)
+	{
+		const ew::Mat4& m = viewProjection;
+		Frustum frustum;
+		for (int i = 0; i < 3; i++)
+		{
+			frustum.planes[i * 2] = makePlane(
+				m.at(0, 3) + m.at(0, i), m.at(1, 3) + m.at(1, i), m.at(2, 3) + m.at(2, i), m.at(3, 3) + m.at(3, i));
+			frustum.planes[i * 2 + 1] = makePlane(
+				m.at(0, 3) - m.at(0, i), m.at(1, 3) - m.at(1, i), m.at(2, 3) - m.at(2, i), m.at(3, 3) - m.at(3, i));
+		}
+		return frustum;
+	}
+
+	/// <summary>
+	/// Rejects the box if it is fully behind any one plane
+	/// </summary>
+	static inline bool intersectsAABB(const Frustum& frustum, float cx, float cy, float cz, float ex, float ey, float ez) {
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+		{
+			const Plane& plane = frustum.planes[p];
+			float d = plane.normal.x * cx + plane.normal.y * cy + plane.normal.z * cz + plane.distance;
+			//Projected radius of the box onto the plane normal
+			float r = fabsf(plane.normal.x) * ex + fabsf(plane.normal.y) * ey + fabsf(plane.normal.z) * ez;
+			if (d + r < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	static inline bool intersectsSphere(const Frustum& frustum, float cx, float cy, float cz, float radius) {
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+		{
+			const Plane& plane = frustum.planes[p];
+			if (plane.normal.x * cx + plane.normal.y * cy + plane.normal.z * cz + plane.distance < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool Intersects(const Frustum& frustum, const AABB& box)
+	{
+		ew::Vec3 c = box.center();
+		ew::Vec3 e = box.extents();
+		return intersectsAABB(frustum, c.x, c.y, c.z, e.x, e.y, e.z);
+	}
+
+	bool Intersects(const Frustum& frustum, const BoundingSphere& sphere)
+	{
+		return intersectsSphere(frustum, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius);
+	}
+
+#if defined(EW_MATH_SSE)
+	/// <summary>
+	/// Writes 1 for each lane not set in the outside mask, 0 for each lane that is
+	/// </summary>
+	static inline void storeVisible(__m128 outside, unsigned char* out) {
+		int bits = ~_mm_movemask_ps(outside);
+		out[0] = bits & 1;
+		out[1] = (bits >> 1) & 1;
+		out[2] = (bits >> 2) & 1;
+		out[3] = (bits >> 3) & 1;
+	}
+#endif
+
+	/// <summary>
+	/// Tests every box in the stream against the frustum, 4 boxes per plane test when SSE is enabled
+	/// </summary>
+	/// <param name="frustum">Frustum from ExtractFrustum</param>
+	/// <param name="centers">World space box centers</param>
+	/// <param name="extents">World space half sizes, same count as centers</param>
+	/// <param name="outVisible">Array of centers.size() to receive 1 if visible, 0 if culled</param>
+	void CullAABBs(const Frustum& frustum, const Vec3Stream& centers, const Vec3Stream& extents, unsigned char* outVisible)
+	{
+		const size_t count = centers.size();
+		const float* cx = centers.x.data();
+		const float* cy = centers.y.data();
+		const float* cz = centers.z.data();
+		const float* ex = extents.x.data();
+		const float* ey = extents.y.data();
+		const float* ez = extents.z.data();
+		size_t i = 0;
+#if defined(EW_MATH_SSE)
+		//Plane components splatted once, with absolute normals for the projected radius
+		__m128 nx[FRUSTUM_PLANE_COUNT], ny[FRUSTUM_PLANE_COUNT], nz[FRUSTUM_PLANE_COUNT], dist[FRUSTUM_PLANE_COUNT];
+		__m128 ax[FRUSTUM_PLANE_COUNT], ay[FRUSTUM_PLANE_COUNT], az[FRUSTUM_PLANE_COUNT];
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+		{
+			const Plane& plane = frustum.planes[p];
+			nx[p] = _mm_set1_ps(plane.normal.x);
+			ny[p] = _mm_set1_ps(plane.normal.y);
+			nz[p] = _mm_set1_ps(plane.normal.z);
+			dist[p] = _mm_set1_ps(plane.distance);
+			ax[p] = _mm_set1_ps(fabsf(plane.normal.x));
+			ay[p] = _mm_set1_ps(fabsf(plane.normal.y));
+			az[p] = _mm_set1_ps(fabsf(plane.normal.z));
+		}
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 vcx = _mm_loadu_ps(cx + i), vcy = _mm_loadu_ps(cy + i), vcz = _mm_loadu_ps(cz + i);
+			__m128 vex = _mm_loadu_ps(ex + i), vey = _mm_loadu_ps(ey + i), vez = _mm_loadu_ps(ez + i);
+			__m128 outside = zero;
+			for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], vcx), _mm_mul_ps(ny[p], vcy)),
+					_mm_mul_ps(nz[p], vcz)), dist[p]);
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], vex), _mm_mul_ps(ay[p], vey)), _mm_mul_ps(az[p], vez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+			}
+			storeVisible(outside, outVisible + i);
+		}
+#endif
+		for (; i < count; i++)
+			outVisible[i] = intersectsAABB(frustum, cx[i], cy[i], cz[i], ex[i], ey[i], ez[i]);
+	}
+
+	/// <summary>
+	/// Tests every sphere in the stream against the frustum, 4 spheres per plane test when SSE is enabled
+	/// </summary>
+	/// <param name="frustum">Frustum from ExtractFrustum</param>
+	/// <param name="centers">World space sphere centers</param>
+	/// <param name="radii">Array of centers.size() radii</param>
+	/// <param name="outVisible">Array of centers.size() to receive 1 if visible, 0 if culled</param>
+	void CullSpheres(const Frustum& frustum, const Vec3Stream& centers, const float* radii, unsigned char* outVisible)
+	{
+		const size_t count = centers.size();
+		const float* cx = centers.x.data();
+		const float* cy = centers.y.data();
+		const float* cz = centers.z.data();
+		size_t i = 0;
+#if defined(EW_MATH_SSE)
+		__m128 nx[FRUSTUM_PLANE_COUNT], ny[FRUSTUM_PLANE_COUNT], nz[FRUSTUM_PLANE_COUNT], dist[FRUSTUM_PLANE_COUNT];
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+		{
+			const Plane& plane = frustum.planes[p];
+			nx[p] = _mm_set1_ps(plane.normal.x);
+			ny[p] = _mm_set1_ps(plane.normal.y);
+			nz[p] = _mm_set1_ps(plane.normal.z);
+			dist[p] = _mm_set1_ps(plane.distance);
+		}
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 vcx = _mm_loadu_ps(cx + i), vcy = _mm_loadu_ps(cy + i), vcz = _mm_loadu_ps(cz + i);
+			__m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(radii + i));
+			__m128 outside = zero;
+			for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], vcx), _mm_mul_ps(ny[p], vcy)),
+					_mm_mul_ps(nz[p], vcz)), dist[p]);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negRadius));
+			}
+			storeVisible(outside, outVisible + i);
+		}
+#endif
+		for (; i < count; i++)
+			outVisible[i] = intersectsSphere(frustum, cx[i], cy[i], cz[i], radii[i]);
+	}
+}
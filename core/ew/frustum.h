@@ -0,0 +1,39 @@
+#pragma once
+#include "bounds.h"
+#include "ewMath/vec3Stream.h"
+
+namespace ew {
+	//Points with Dot(normal, p) + distance >= 0 are on the inside
+	struct Plane {
+		ew::Vec3 normal = ew::Vec3(0.0f, 1.0f, 0.0f);
+		float distance = 0.0f;
+	};
+
+	enum FrustumPlane {
+		FRUSTUM_LEFT = 0,
+		FRUSTUM_RIGHT,
+		FRUSTUM_BOTTOM,
+		FRUSTUM_TOP,
+		FRUSTUM_NEAR,
+		FRUSTUM_FAR,
+		FRUSTUM_PLANE_COUNT
+	};
+
+	//Six inward facing planes with unit length normals
+	struct Frustum {
+		Plane planes[FRUSTUM_PLANE_COUNT];
+	};
+
+	//Extracts the planes of viewProjection (e.g. camera.ProjectionMatrix() * camera.ViewMatrix()) in world space.
+	//Works for both perspective and orthographic projections.
+	Frustum ExtractFrustum(const ew::Mat4& viewProjection);
+
+	//Conservative: may return true for boxes just outside a frustum corner, never false for a visible box
+	bool Intersects(const Frustum& frustum, const AABB& box);
+	bool Intersects(const Frustum& frustum, const BoundingSphere& sphere);
+
+	//outVisible[i] = Intersects(frustum, box i), for boxes given as centers and half extents
+	void CullAABBs(const Frustum& frustum, const Vec3Stream& centers, const Vec3Stream& extents, unsigned char* outVisible);
+	//outVisible[i] = Intersects(frustum, sphere i)
+	void CullSpheres(const Frustum& frustum, const Vec3Stream& centers, const float* radii, unsigned char* outVisible);
+}
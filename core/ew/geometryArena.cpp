@@ -0,0 +1,226 @@
+#include "geometryArena.h"
+#include <stdio.h>
+#include "glStateCache.h"
+#include "external/glad.h"
+
+namespace ew {
+	int GeometryArena::FreeList::allocate(int size)
+	{
+		if (size <= 0)
+			return 0;
+		for (size_t i = 0; i < m_ranges.size(); i++)
+		{
+			Range& range = m_ranges[i];
+			if (range.size < size)
+				continue;
+			int offset = range.offset;
+			range.offset += size;
+			range.size -= size;
+			if (range.size == 0)
+				m_ranges.erase(m_ranges.begin() + i);
+			return offset;
+		}
+		return -1;
+	}
+
+	/// <summary>
+	/// Returns a range to the list, merging it with the free ranges right before and after it
+	/// </summary>
+	void GeometryArena::FreeList::release(int offset, int size)
+	{
+		if (size <= 0)
+			return;
+		size_t i = 0;
+		while (i < m_ranges.size() && m_ranges[i].offset < offset)
+			i++;
+		bool mergePrevious = i > 0 && m_ranges[i - 1].offset + m_ranges[i - 1].size == offset;
+		bool mergeNext = i < m_ranges.size() && offset + size == m_ranges[i].offset;
+		if (mergePrevious && mergeNext) {
+			m_ranges[i - 1].size += size + m_ranges[i].size;
+			m_ranges.erase(m_ranges.begin() + i);
+		}
+		else if (mergePrevious) {
+			m_ranges[i - 1].size += size;
+		}
+		else if (mergeNext) {
+			m_ranges[i].offset = offset;
+			m_ranges[i].size += size;
+		}
+		else {
+			Range range = { offset, size };
+			m_ranges.insert(m_ranges.begin() + i, range);
+		}
+	}
+
+	int GeometryArena::FreeList::getNumFree() const
+	{
+		int numFree = 0;
+		for (size_t i = 0; i < m_ranges.size(); i++)
+			numFree += m_ranges[i].size;
+		return numFree;
+	}
+
+	GeometryArena::GeometryArena(int vertexCapacity, int indexCapacity)
+	{
+		create(vertexCapacity, indexCapacity);
+	}
+
+	/// <summary>
+	/// Allocates immutable storage for the vertex and index buffers and sets up the shared VAO.
+	/// Meshes added before are discarded.
+	/// </summary>
+	void GeometryArena::create(int vertexCapacity, int indexCapacity)
+	{
+		GLStateCache& glState = ew::getGLStateCache();
+		if (m_vao != 0) {
+			glState.forgetVertexArray(m_vao);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteBuffers(1, &m_vbo);
+			glDeleteBuffers(1, &m_ebo);
+		}
+		m_vertexCapacity = vertexCapacity > 1 ? vertexCapacity : 1;
+		m_indexCapacity = indexCapacity > 1 ? indexCapacity : 1;
+		m_freeVertices.clear();
+		m_freeIndices.clear();
+		m_freeVertices.release(0, m_vertexCapacity);
+		m_freeIndices.release(0, m_indexCapacity);
+
+		//Immutable storage can't be resized, only written. Growing copies into a new buffer.
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * m_vertexCapacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glGenBuffers(1, &m_ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * m_indexCapacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		//Same attribute locations as Mesh, but read through a vertex buffer binding so the buffer can be swapped on growth
+		glGenVertexArrays(1, &m_vao);
+		glState.bindVertexArray(m_vao);
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+		glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+		glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			glVertexAttribBinding(i, 0);
+			glEnableVertexAttribArray(i);
+		}
+		glBindVertexBuffer(0, m_vbo, 0, sizeof(Vertex));
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glState.bindVertexArray(0);
+	}
+
+	/// <summary>
+	/// Moves the vertices into a bigger buffer. Offsets don't change, so existing handles stay valid.
+	/// </summary>
+	void GeometryArena::growVertices(int minCapacity)
+	{
+		int capacity = m_vertexCapacity * 2 > minCapacity ? m_vertexCapacity * 2 : minCapacity;
+		unsigned int vbo = 0;
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * capacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(Vertex) * m_vertexCapacity);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &m_vbo);
+		m_vbo = vbo;
+		m_freeVertices.release(m_vertexCapacity, capacity - m_vertexCapacity);
+		m_vertexCapacity = capacity;
+
+		GLStateCache& glState = ew::getGLStateCache();
+		glState.bindVertexArray(m_vao);
+		glBindVertexBuffer(0, m_vbo, 0, sizeof(Vertex));
+	}
+
+	void GeometryArena::growIndices(int minCapacity)
+	{
+		int capacity = m_indexCapacity * 2 > minCapacity ? m_indexCapacity * 2 : minCapacity;
+		unsigned int ebo = 0;
+		glGenBuffers(1, &ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * capacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_ebo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(unsigned int) * m_indexCapacity);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &m_ebo);
+		m_ebo = ebo;
+		m_freeIndices.release(m_indexCapacity, capacity - m_indexCapacity);
+		m_indexCapacity = capacity;
+
+		//The element buffer binding is part of the VAO
+		GLStateCache& glState = ew::getGLStateCache();
+		glState.bindVertexArray(m_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+	}
+
+	MeshHandle GeometryArena::add(const MeshData& meshData)
+	{
+		MeshHandle handle;
+		int numVertices = (int)meshData.vertices.size();
+		int numIndices = (int)meshData.indices.size();
+		if (numVertices == 0)
+			return handle;
+		int baseVertex = m_freeVertices.allocate(numVertices);
+		if (baseVertex < 0) {
+			//The tail added by growing merges with a free range at the end, so this only grows as much as needed
+			growVertices(m_vertexCapacity + numVertices);
+			baseVertex = m_freeVertices.allocate(numVertices);
+		}
+		int firstIndex = m_freeIndices.allocate(numIndices);
+		if (firstIndex < 0) {
+			growIndices(m_indexCapacity + numIndices);
+			firstIndex = m_freeIndices.allocate(numIndices);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * baseVertex, sizeof(Vertex) * numVertices, meshData.vertices.data());
+		if (numIndices > 0) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * firstIndex, sizeof(unsigned int) * numIndices, meshData.indices.data());
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		handle.baseVertex = baseVertex;
+		handle.firstIndex = firstIndex;
+		handle.numVertices = numVertices;
+		handle.numIndices = numIndices;
+		handle.bounds = ComputeAABB(&meshData.vertices[0].pos, meshData.vertices.size(), sizeof(Vertex));
+		return handle;
+	}
+
+	void GeometryArena::remove(const MeshHandle& handle)
+	{
+		if (!handle.isValid())
+			return;
+		m_freeVertices.release(handle.baseVertex, handle.numVertices);
+		m_freeIndices.release(handle.firstIndex, handle.numIndices);
+	}
+
+	MeshHandle GeometryArena::reload(const MeshHandle& handle, const MeshData& meshData)
+	{
+		remove(handle);
+		return add(meshData);
+	}
+
+	void GeometryArena::bind() const
+	{
+		ew::getGLStateCache().bindVertexArray(m_vao);
+	}
+
+	void GeometryArena::draw(const MeshHandle& handle, DrawMode drawMode) const
+	{
+		if (!handle.isValid())
+			return;
+		bind();
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsBaseVertex(GL_TRIANGLES, handle.numIndices, GL_UNSIGNED_INT,
+				(const void*)(sizeof(unsigned int) * handle.firstIndex), handle.baseVertex);
+		}
+		else {
+			glDrawArrays(GL_POINTS, handle.baseVertex, handle.numVertices);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+#include "bounds.h"
+
+namespace ew {
+	//A mesh stored in a GeometryArena. Indices are relative to baseVertex.
+	struct MeshHandle {
+		int baseVertex = 0;
+		int firstIndex = 0;
+		int numVertices = 0;
+		int numIndices = 0;
+		AABB bounds; //Object space
+		inline bool isValid()const { return numVertices > 0; }
+	};
+
+	//Vertices and indices of many meshes in one vertex buffer and one index buffer, behind a single VAO.
+	//Ranges are handed out from free lists, so removing or reloading a mesh leaves the others in place.
+	//Drawing meshes from the same arena never switches buffers, which batching and multi-draw rely on.
+	class GeometryArena {
+	public:
+		GeometryArena() {};
+		GeometryArena(int vertexCapacity, int indexCapacity);
+		void create(int vertexCapacity, int indexCapacity);
+
+		//Copies the mesh into the arena, growing it if there is no free range big enough
+		MeshHandle add(const MeshData& meshData);
+		//Frees the mesh's ranges for later meshes. The handle must not be drawn afterwards.
+		void remove(const MeshHandle& handle);
+		//Replaces a mesh's data. Its ranges are freed first, so the new data can reuse them.
+		//The old handle must not be drawn afterwards.
+		MeshHandle reload(const MeshHandle& handle, const MeshData& meshData);
+
+		void bind()const;
+		//Binds the arena's VAO and draws one mesh. Many meshes are cheaper to draw with a DrawBatch.
+		void draw(const MeshHandle& handle, DrawMode drawMode = DrawMode::TRIANGLES)const;
+
+		inline unsigned int getVertexArray()const { return m_vao; }
+		inline unsigned int getVertexBuffer()const { return m_vbo; }
+		inline unsigned int getIndexBuffer()const { return m_ebo; }
+		inline int getVertexCapacity()const { return m_vertexCapacity; }
+		inline int getIndexCapacity()const { return m_indexCapacity; }
+		inline int getNumFreeVertices()const { return m_freeVertices.getNumFree(); }
+		inline int getNumFreeIndices()const { return m_freeIndices.getNumFree(); }
+	private:
+		//Free ranges sorted by offset, adjacent ranges are always merged
+		class FreeList {
+		public:
+			//First fit. Returns -1 if no range is big enough.
+			int allocate(int size);
+			void release(int offset, int size);
+			int getNumFree()const;
+			inline void clear() { m_ranges.clear(); }
+		private:
+			struct Range {
+				int offset;
+				int size;
+			};
+			std::vector<Range> m_ranges;
+		};
+		void growVertices(int minCapacity);
+		void growIndices(int minCapacity);
+
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		int m_vertexCapacity = 0;
+		int m_indexCapacity = 0;
+		FreeList m_freeVertices;
+		FreeList m_freeIndices;
+	};
+}
@@ -0,0 +1,148 @@
+#include "glStateCache.h"
+#include "external/glad.h"
+
+namespace ew {
+	GLStateCache& getGLStateCache()
+	{
+		static GLStateCache cache;
+		return cache;
+	}
+
+	bool GLStateCache::change(int& shadow, int value)
+	{
+		if (shadow == value) {
+			m_skipped++;
+			return false;
+		}
+		shadow = value;
+		m_issued++;
+		return true;
+	}
+
+	void GLStateCache::useProgram(unsigned int program)
+	{
+		if (change(m_program, (int)program))
+			glUseProgram(program);
+	}
+
+	void GLStateCache::bindVertexArray(unsigned int vao)
+	{
+		if (change(m_vao, (int)vao))
+			glBindVertexArray(vao);
+	}
+
+	void GLStateCache::activeTexture(int unit)
+	{
+		if (change(m_activeUnit, unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	/// <summary>
+	/// Binds a texture to a texture unit. The active unit is only switched when a bind is actually needed,
+	/// so rebinding the same textures every frame costs no GL calls at all.
+	/// </summary>
+	/// <param name="unit">Texture unit index, 0 for GL_TEXTURE0</param>
+	/// <param name="target">GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, etc.</param>
+	/// <param name="texture">Texture name, 0 to unbind</param>
+	void GLStateCache::bindTexture(int unit, unsigned int target, unsigned int texture)
+	{
+		int* shadow = nullptr;
+		if (unit >= 0 && unit < MAX_TEXTURE_UNITS) {
+			if (target == GL_TEXTURE_2D)
+				shadow = &m_texture2D[unit];
+			else if (target == GL_TEXTURE_CUBE_MAP)
+				shadow = &m_textureCube[unit];
+		}
+		if (shadow != nullptr && !change(*shadow, (int)texture))
+			return;
+		if (shadow == nullptr)
+			m_issued++;
+		activeTexture(unit);
+		glBindTexture(target, texture);
+	}
+
+	void GLStateCache::setEnabled(unsigned int capability, bool enabled)
+	{
+		int* shadow = nullptr;
+		switch (capability) {
+		case GL_DEPTH_TEST:
+			shadow = &m_depthTest;
+			break;
+		case GL_CULL_FACE:
+			shadow = &m_cullFace;
+			break;
+		case GL_BLEND:
+			shadow = &m_blend;
+			break;
+		default:
+			m_issued++;
+			break;
+		}
+		if (shadow != nullptr && !change(*shadow, enabled ? 1 : 0))
+			return;
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+
+	void GLStateCache::depthMask(bool write)
+	{
+		if (change(m_depthMask, write ? 1 : 0))
+			glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+
+	void GLStateCache::depthFunc(unsigned int func)
+	{
+		if (change(m_depthFunc, (int)func))
+			glDepthFunc(func);
+	}
+
+	void GLStateCache::cullFace(unsigned int face)
+	{
+		if (change(m_cullFaceMode, (int)face))
+			glCullFace(face);
+	}
+
+	void GLStateCache::blendFunc(unsigned int srcFactor, unsigned int dstFactor)
+	{
+		//One call sets both factors, so it only counts once
+		if (m_blendSrc == (int)srcFactor && m_blendDst == (int)dstFactor) {
+			m_skipped++;
+			return;
+		}
+		m_blendSrc = (int)srcFactor;
+		m_blendDst = (int)dstFactor;
+		m_issued++;
+		glBlendFunc(srcFactor, dstFactor);
+	}
+
+	void GLStateCache::invalidate()
+	{
+		m_program = m_vao = m_activeUnit = -1;
+		for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+			m_texture2D[i] = m_textureCube[i] = -1;
+		m_depthTest = m_cullFace = m_blend = -1;
+		m_depthMask = m_depthFunc = m_cullFaceMode = -1;
+		m_blendSrc = m_blendDst = -1;
+	}
+
+	void GLStateCache::forgetProgram(unsigned int program)
+	{
+		if (m_program == (int)program)
+			m_program = -1;
+	}
+
+	void GLStateCache::forgetVertexArray(unsigned int vao)
+	{
+		if (m_vao == (int)vao)
+			m_vao = -1;
+	}
+
+	void GLStateCache::beginFrame()
+	{
+		m_lastIssued = m_issued;
+		m_lastSkipped = m_skipped;
+		m_issued = m_skipped = 0;
+	}
+}
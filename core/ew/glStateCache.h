@@ -0,0 +1,65 @@
+#pragma once
+
+namespace ew {
+	//Shadow copy of the GL state the render loops change most: the bound program, VAO, textures per unit,
+	//and depth, cull and blend state. Calls that would set a value that is already current are skipped.
+	//Everything starts out unknown, so the first call for each piece of state always reaches GL.
+	//Raw GL calls that change shadowed state make the copy stale, call invalidate() after them.
+	class GLStateCache {
+	public:
+		static const int MAX_TEXTURE_UNITS = 32;
+
+		GLStateCache() { invalidate(); };
+
+		void useProgram(unsigned int program);
+		void bindVertexArray(unsigned int vao);
+		//Also sets the active texture unit, but only if the texture binding actually changes.
+		//GL_TEXTURE_2D and GL_TEXTURE_CUBE_MAP are shadowed, other targets are always bound.
+		void bindTexture(int unit, unsigned int target, unsigned int texture);
+		//GL_DEPTH_TEST, GL_CULL_FACE and GL_BLEND are shadowed, other capabilities always reach GL
+		void setEnabled(unsigned int capability, bool enabled);
+		inline void enable(unsigned int capability) { setEnabled(capability, true); }
+		inline void disable(unsigned int capability) { setEnabled(capability, false); }
+		void depthMask(bool write);
+		void depthFunc(unsigned int func);
+		void cullFace(unsigned int face);
+		void blendFunc(unsigned int srcFactor, unsigned int dstFactor);
+
+		//Forgets everything, e.g. after code outside the cache changed bindings
+		void invalidate();
+		//Call before deleting a program or VAO, so a new object reusing the name isn't mistaken for it
+		void forgetProgram(unsigned int program);
+		void forgetVertexArray(unsigned int vao);
+
+		//Starts counting a new frame. The getters report the frame before.
+		void beginFrame();
+		inline int getNumIssued()const { return m_lastIssued; }
+		inline int getNumSkipped()const { return m_lastSkipped; }
+	private:
+		//True if the call has to be made. Counts it either way.
+		bool change(int& shadow, int value);
+		void activeTexture(int unit);
+
+		int m_program = -1;
+		int m_vao = -1;
+		int m_activeUnit = -1;
+		int m_texture2D[MAX_TEXTURE_UNITS]; //Per unit, -1 if unknown
+		int m_textureCube[MAX_TEXTURE_UNITS];
+		int m_depthTest = -1;
+		int m_cullFace = -1;
+		int m_blend = -1;
+		int m_depthMask = -1;
+		int m_depthFunc = -1;
+		int m_cullFaceMode = -1;
+		int m_blendSrc = -1;
+		int m_blendDst = -1;
+
+		int m_issued = 0;
+		int m_skipped = 0;
+		int m_lastIssued = 0;
+		int m_lastSkipped = 0;
+	};
+
+	//The cache for the current context. The assignments only ever create one.
+	GLStateCache& getGLStateCache();
+}
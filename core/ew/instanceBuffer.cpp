@@ -0,0 +1,33 @@
+#include "instanceBuffer.h"
+
+namespace ew {
+	InstanceBuffer::InstanceBuffer(int capacity)
+	{
+		create(capacity);
+	}
+
+	/// <summary>
+	/// Allocates GPU storage for capacity instances per upload. Instances uploaded before are discarded.
+	/// </summary>
+	void InstanceBuffer::create(int capacity)
+	{
+		m_capacity = capacity > 1 ? capacity : 1;
+		m_count = 0;
+		m_offset = 0;
+		m_stream.create(sizeof(InstanceData) * m_capacity);
+	}
+
+	void InstanceBuffer::upload(const InstanceData* instances, int count)
+	{
+		if (count > m_capacity) {
+			int capacity = m_capacity * 2;
+			create(capacity > count ? capacity : count);
+		}
+		m_count = count;
+		if (count <= 0)
+			return;
+		//Every draw of the previous upload has been issued by now, so its region can be fenced
+		m_stream.beginFrame();
+		m_offset = m_stream.write(instances, sizeof(InstanceData) * count).offset;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "ewMath/ewMath.h"
+#include "streamBuffer.h"
+
+namespace ew {
+	//Vertex attribute locations of the per instance data, after the Vertex attributes (0-2).
+	//A mat4 attribute takes one location per column.
+	const unsigned int INSTANCE_ATTRIBUTE_MODEL = 3; //layout(location = 3) in mat4, uses 3-6
+	const unsigned int INSTANCE_ATTRIBUTE_COLOR = 7; //layout(location = 7) in vec4
+	//Vertex buffer binding index the instance buffer is bound to, separate from the mesh's own
+	const unsigned int INSTANCE_BUFFER_BINDING = 8;
+
+	struct InstanceData {
+		ew::Mat4 model;
+		ew::Vec4 color = ew::Vec4(1.0f);
+	};
+	static_assert(sizeof(InstanceData) == 80, "InstanceData must be tightly packed");
+
+	//Per instance attributes for Mesh::drawInstanced, rewritten every frame.
+	//Each upload goes into the next region of a StreamBuffer, so it never waits on draws that still read
+	//the instances of the last few uploads.
+	class InstanceBuffer {
+	public:
+		InstanceBuffer() {};
+		InstanceBuffer(int capacity);
+		void create(int capacity);
+
+		//Replaces all instances, growing the buffer if needed
+		void upload(const InstanceData* instances, int count);
+		inline int getCount()const { return m_count; }
+		inline unsigned int getBuffer()const { return m_stream.getBuffer(); }
+		//Offset of the last upload's instances in the buffer
+		inline size_t getOffset()const { return m_offset; }
+		inline int getNumFenceWaits()const { return m_stream.getNumFenceWaits(); }
+	private:
+		StreamBuffer m_stream;
+		size_t m_offset = 0;
+		int m_capacity = 0;
+		int m_count = 0;
+	};
+}
@@ -0,0 +1,123 @@
+#include "lightBuffer.h"
+#include "external/glad.h"
+
+namespace ew {
+	static inline bool equalVec3(const ew::Vec3& a, const ew::Vec3& b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	LightBuffer::LightBuffer(int capacity)
+	{
+		create(capacity);
+	}
+
+	/// <summary>
+	/// Allocates GPU storage for capacity lights. Lights already in the list are uploaded again on the next upload().
+	/// </summary>
+	void LightBuffer::create(int capacity)
+	{
+		if (m_ssbo == 0)
+			glGenBuffers(1, &m_ssbo);
+		m_capacity = capacity > 1 ? capacity : 1;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ssbo);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(PointLight) * m_capacity, NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_dirtyBegin = 0;
+		m_dirtyEnd = getCount();
+	}
+
+	int LightBuffer::add(const PointLight& light)
+	{
+		m_lights.push_back(light);
+		markDirty(getCount() - 1);
+		return getCount() - 1;
+	}
+
+	void LightBuffer::resize(int count)
+	{
+		int previous = getCount();
+		m_lights.resize(count);
+		for (int i = previous; i < count; i++)
+			markDirty(i);
+	}
+
+	ew::Vec3 LightBuffer::getTotalColor(int count) const
+	{
+		ew::Vec3 total = ew::Vec3(0.0f);
+		for (int i = 0; i < count && i < getCount(); i++)
+			total += m_lights[i].color * m_lights[i].intensity;
+		return total;
+	}
+
+	void LightBuffer::set(int index, const PointLight& light)
+	{
+		PointLight& current = m_lights[index];
+		if (equalVec3(current.position, light.position) && current.radius == light.radius
+			&& equalVec3(current.color, light.color) && current.intensity == light.intensity)
+			return;
+		current = light;
+		markDirty(index);
+	}
+
+	void LightBuffer::setPosition(int index, const ew::Vec3& position)
+	{
+		if (equalVec3(m_lights[index].position, position))
+			return;
+		m_lights[index].position = position;
+		markDirty(index);
+	}
+
+	void LightBuffer::setColor(int index, const ew::Vec3& color)
+	{
+		if (equalVec3(m_lights[index].color, color))
+			return;
+		m_lights[index].color = color;
+		markDirty(index);
+	}
+
+	void LightBuffer::setRadius(int index, float radius)
+	{
+		if (m_lights[index].radius == radius)
+			return;
+		m_lights[index].radius = radius;
+		markDirty(index);
+	}
+
+	/// <summary>
+	/// Grows the dirty range to include a light. Changes are coalesced into one contiguous range,
+	/// which is a single glBufferSubData no matter how many lights inside it changed.
+	/// </summary>
+	void LightBuffer::markDirty(int index)
+	{
+		if (m_dirtyBegin >= m_dirtyEnd) {
+			m_dirtyBegin = index;
+			m_dirtyEnd = index + 1;
+			return;
+		}
+		m_dirtyBegin = index < m_dirtyBegin ? index : m_dirtyBegin;
+		m_dirtyEnd = index + 1 > m_dirtyEnd ? index + 1 : m_dirtyEnd;
+	}
+
+	void LightBuffer::upload()
+	{
+		if (getCount() > m_capacity) {
+			//Double so lights added one at a time don't reallocate every frame
+			int capacity = m_capacity * 2;
+			create(capacity > getCount() ? capacity : getCount());
+		}
+		if (m_dirtyEnd > getCount())
+			m_dirtyEnd = getCount();
+		if (m_dirtyBegin >= m_dirtyEnd)
+			return;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ssbo);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(PointLight) * m_dirtyBegin,
+			sizeof(PointLight) * (m_dirtyEnd - m_dirtyBegin), m_lights.data() + m_dirtyBegin);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
+
+	void LightBuffer::bind(unsigned int binding) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_ssbo);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	//Shader storage bindings (separate from uniform buffer bindings)
+	const unsigned int STORAGE_BINDING_LIGHTS = 0;
+	const unsigned int STORAGE_BINDING_CLUSTER_GRID = 1;
+	const unsigned int STORAGE_BINDING_CLUSTER_INDICES = 2;
+
+	//std430 struct Light { vec3 position; float radius; vec3 color; float intensity; }
+	struct PointLight {
+		ew::Vec3 position = ew::Vec3(0.0f);
+		float radius = 10.0f; //No contribution past this distance
+		ew::Vec3 color = ew::Vec3(1.0f);
+		float intensity = 1.0f;
+	};
+	static_assert(sizeof(PointLight) == 32, "PointLight must match std430");
+
+	//CPU list of point lights mirrored in a shader storage buffer. Only the range of lights
+	//changed since the last upload() is sent to the GPU.
+	class LightBuffer {
+	public:
+		LightBuffer() {};
+		LightBuffer(int capacity);
+		void create(int capacity);
+
+		inline int getCount()const { return (int)m_lights.size(); }
+		inline const PointLight& get(int index)const { return m_lights[index]; }
+		inline const PointLight* getLights()const { return m_lights.data(); }
+		int add(const PointLight& light);
+		void resize(int count);
+		//Setters only mark the light dirty if the value actually changed
+		void set(int index, const PointLight& light);
+		void setPosition(int index, const ew::Vec3& position);
+		void setColor(int index, const ew::Vec3& color);
+		void setRadius(int index, float radius);
+		//Sum of color * intensity over the first count lights
+		ew::Vec3 getTotalColor(int count)const;
+
+		//Sends changed lights to the GPU, growing the buffer if needed
+		void upload();
+		void bind(unsigned int binding = STORAGE_BINDING_LIGHTS)const;
+		inline unsigned int getBuffer()const { return m_ssbo; }
+	private:
+		void markDirty(int index);
+
+		std::vector<PointLight> m_lights;
+		unsigned int m_ssbo = 0;
+		int m_capacity = 0;
+		int m_dirtyBegin = 0; //Dirty lights are [m_dirtyBegin, m_dirtyEnd)
+		int m_dirtyEnd = 0;
+	};
+}
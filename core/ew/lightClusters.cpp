@@ -0,0 +1,310 @@
+#include "lightClusters.h"
+#include <math.h>
+#include <thread>
+#include <functional>
+#include "external/glad.h"
+#if defined(EW_MATH_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace ew {
+	//Below this, starting threads costs more than binning on one
+	static const int MIN_LIGHTS_FOR_THREADING = 256;
+
+	static inline float minf(float a, float b) { return a < b ? a : b; }
+	static inline float maxf(float a, float b) { return a > b ? a : b; }
+
+	LightClusters::LightClusters(int gridX, int gridY, int gridZ)
+	{
+		create(gridX, gridY, gridZ);
+	}
+
+	/// <summary>
+	/// Allocates the cluster grid. 16x9x24 fits a 16:9 screen with square-ish tiles.
+	/// </summary>
+	void LightClusters::create(int gridX, int gridY, int gridZ)
+	{
+		m_gridX = gridX > 1 ? gridX : 1;
+		m_gridY = gridY > 1 ? gridY : 1;
+		m_gridZ = gridZ > 1 ? gridZ : 1;
+		int numClusters = getNumClusters();
+		m_minX.resize(numClusters); m_minY.resize(numClusters); m_minZ.resize(numClusters);
+		m_maxX.resize(numClusters); m_maxY.resize(numClusters); m_maxZ.resize(numClusters);
+		m_grid.assign(numClusters * 2, 0);
+		m_sliceLights.resize(m_gridZ);
+		m_boundsValid = false;
+		m_buffersValid = false;
+	}
+
+	/// <summary>
+	/// Computes the view space AABB of every cluster. Slice k covers depths near * (far/near)^(k/Z) to
+	/// near * (far/near)^((k+1)/Z), so clusters stay roughly cube shaped instead of stretching with distance.
+	/// Only depends on the projection, so it is only redone when that changes.
+	/// </summary>
+	void LightClusters::buildClusterBounds(const ew::Camera& camera)
+	{
+		//Slices are logarithmic in depth, so near has to be positive
+		float nearPlane = camera.nearPlane > 0.001f ? camera.nearPlane : 0.001f;
+		float farPlane = camera.farPlane > nearPlane * 1.01f ? camera.farPlane : nearPlane * 1.01f;
+		//Half size of the view volume at depth 1 (perspective) or at any depth (orthographic)
+		float halfHeight = camera.orthographic ? camera.orthoHeight * 0.5f : tanf(ew::Radians(camera.fov) * 0.5f);
+		float halfWidth = halfHeight * camera.aspectRatio;
+
+		for (int z = 0; z < m_gridZ; z++)
+		{
+			float sliceNear = nearPlane * powf(farPlane / nearPlane, (float)z / m_gridZ);
+			float sliceFar = nearPlane * powf(farPlane / nearPlane, (float)(z + 1) / m_gridZ);
+			//Tiles widen with depth in perspective, so the box has to cover the tile at both ends
+			float scaleNear = camera.orthographic ? 1.0f : sliceNear;
+			float scaleFar = camera.orthographic ? 1.0f : sliceFar;
+			for (int y = 0; y < m_gridY; y++)
+			{
+				float ndcMinY = -1.0f + 2.0f * y / m_gridY;
+				float ndcMaxY = -1.0f + 2.0f * (y + 1) / m_gridY;
+				for (int x = 0; x < m_gridX; x++)
+				{
+					float ndcMinX = -1.0f + 2.0f * x / m_gridX;
+					float ndcMaxX = -1.0f + 2.0f * (x + 1) / m_gridX;
+					int i = clusterIndex(x, y, z);
+					m_minX[i] = minf(ndcMinX * scaleNear, ndcMinX * scaleFar) * halfWidth;
+					m_maxX[i] = maxf(ndcMaxX * scaleNear, ndcMaxX * scaleFar) * halfWidth;
+					m_minY[i] = minf(ndcMinY * scaleNear, ndcMinY * scaleFar) * halfHeight;
+					m_maxY[i] = maxf(ndcMaxY * scaleNear, ndcMaxY * scaleFar) * halfHeight;
+					//Camera looks down -z
+					m_minZ[i] = -sliceFar;
+					m_maxZ[i] = -sliceNear;
+				}
+			}
+		}
+		m_boundsCamera = camera;
+		m_boundsValid = true;
+		m_nearPlane = nearPlane;
+		m_farPlane = farPlane;
+	}
+
+	/// <summary>
+	/// Builds the per cluster light lists
+	/// </summary>
+	/// <param name="camera">Camera the clusters are built for</param>
+	/// <param name="lights">Lights in world space</param>
+	/// <param name="count">Number of lights</param>
+	/// <param name="threadCount">Max number of threads to bin with. Small light counts always use one.</param>
+	void LightClusters::update(const ew::Camera& camera, const PointLight* lights, int count, int threadCount)
+	{
+		const ew::Camera& c = m_boundsCamera;
+		if (!m_boundsValid || c.fov != camera.fov || c.aspectRatio != camera.aspectRatio
+			|| c.nearPlane != camera.nearPlane || c.farPlane != camera.farPlane
+			|| c.orthographic != camera.orthographic || c.orthoHeight != camera.orthoHeight)
+			buildClusterBounds(camera);
+
+		//Lights to view space, where the cluster bounds are
+		count = count > 0 ? count : 0;
+		if (count > 0)
+			m_lightPositions.load(&lights[0].position, count, sizeof(PointLight));
+		else
+			m_lightPositions.resize(0);
+		ew::TransformPoints(camera.ViewMatrix(), m_lightPositions, m_viewPositions);
+		m_radii.resize(count);
+
+		//Bucket lights by the depth slices they overlap, so each cluster only tests lights near its slice
+		float logScale = m_gridZ / logf(m_farPlane / m_nearPlane);
+		for (int z = 0; z < m_gridZ; z++)
+			m_sliceLights[z].clear();
+		for (int i = 0; i < count; i++)
+		{
+			float radius = lights[i].radius;
+			m_radii[i] = radius;
+			float depth = -m_viewPositions.z[i];
+			float depthMin = depth - radius;
+			float depthMax = depth + radius;
+			if (depthMax < m_nearPlane || depthMin > m_farPlane)
+				continue;
+			//One slice of margin each way for rounding, the cluster test is exact anyway
+			int first = depthMin <= m_nearPlane ? 0 : (int)(logf(depthMin / m_nearPlane) * logScale) - 1;
+			int last = depthMax >= m_farPlane ? m_gridZ - 1 : (int)(logf(depthMax / m_nearPlane) * logScale) + 1;
+			first = first < 0 ? 0 : first;
+			last = last >= m_gridZ ? m_gridZ - 1 : last;
+			for (int z = first; z <= last; z++)
+				m_sliceLights[z].push_back((unsigned int)i);
+		}
+
+		//Each thread owns a contiguous range of slices and writes its own index list, so the lists
+		//can simply be concatenated afterwards
+		int numThreads = count < MIN_LIGHTS_FOR_THREADING ? 1 : threadCount;
+		numThreads = numThreads < 1 ? 1 : (numThreads > m_gridZ ? m_gridZ : numThreads);
+		std::vector<std::vector<unsigned int>> threadIndices(numThreads);
+		std::vector<std::thread> threads;
+		for (int t = 1; t < numThreads; t++)
+		{
+			int firstSlice = m_gridZ * t / numThreads;
+			int endSlice = m_gridZ * (t + 1) / numThreads;
+			threads.emplace_back(&LightClusters::binSlices, this, firstSlice, endSlice, std::ref(threadIndices[t]));
+		}
+		binSlices(0, m_gridZ / numThreads, threadIndices[0]);
+		for (size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+
+		m_indices.clear();
+		for (int t = 0; t < numThreads; t++)
+		{
+			unsigned int base = (unsigned int)m_indices.size();
+			int firstCluster = m_gridX * m_gridY * (m_gridZ * t / numThreads);
+			int endCluster = m_gridX * m_gridY * (m_gridZ * (t + 1) / numThreads);
+			for (int i = firstCluster; i < endCluster; i++)
+				m_grid[i * 2] += base;
+			m_indices.insert(m_indices.end(), threadIndices[t].begin(), threadIndices[t].end());
+		}
+	}
+
+	//Lights as structure of arrays, padded to a multiple of 4 with spheres that touch nothing
+	struct SphereSet {
+		std::vector<float> x, y, z, radiusSq;
+		std::vector<unsigned int> ids;
+
+		void build(const std::vector<unsigned int>& lightIds, const ew::Vec3Stream& positions, const std::vector<float>& radii) {
+			size_t padded = (lightIds.size() + 3) & ~(size_t)3;
+			x.assign(padded, 0.0f); y.assign(padded, 0.0f); z.assign(padded, 0.0f);
+			radiusSq.assign(padded, -1.0f);
+			ids = lightIds;
+			for (size_t j = 0; j < lightIds.size(); j++)
+			{
+				unsigned int light = lightIds[j];
+				x[j] = positions.x[light];
+				y[j] = positions.y[light];
+				z[j] = positions.z[light];
+				radiusSq[j] = radii[light] * radii[light];
+			}
+		}
+	};
+
+	/// <summary>
+	/// Appends the ids of the spheres touching a box. A sphere touches the box if the squared distance
+	/// from its center to the closest point in the box is at most radius squared.
+	/// </summary>
+	static void appendOverlapping(const float* boxMin, const float* boxMax, const SphereSet& spheres, std::vector<unsigned int>& outIds)
+	{
+		size_t count = spheres.ids.size();
+		size_t j = 0;
+#if defined(EW_MATH_SSE)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minX = _mm_set1_ps(boxMin[0]), maxX = _mm_set1_ps(boxMax[0]);
+		const __m128 minY = _mm_set1_ps(boxMin[1]), maxY = _mm_set1_ps(boxMax[1]);
+		const __m128 minZ = _mm_set1_ps(boxMin[2]), maxZ = _mm_set1_ps(boxMax[2]);
+		for (; j < count; j += 4)
+		{
+			__m128 px = _mm_loadu_ps(&spheres.x[j]), py = _mm_loadu_ps(&spheres.y[j]), pz = _mm_loadu_ps(&spheres.z[j]);
+			//Distance outside the box along each axis, zero if inside
+			__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minX, px), zero), _mm_max_ps(_mm_sub_ps(px, maxX), zero));
+			__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minY, py), zero), _mm_max_ps(_mm_sub_ps(py, maxY), zero));
+			__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minZ, pz), zero), _mm_max_ps(_mm_sub_ps(pz, maxZ), zero));
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_loadu_ps(&spheres.radiusSq[j])));
+			for (size_t k = 0; mask != 0; k++, mask >>= 1)
+			{
+				if (mask & 1)
+					outIds.push_back(spheres.ids[j + k]);
+			}
+		}
+#endif
+		for (; j < count; j++)
+		{
+			float dx = maxf(boxMin[0] - spheres.x[j], 0.0f) + maxf(spheres.x[j] - boxMax[0], 0.0f);
+			float dy = maxf(boxMin[1] - spheres.y[j], 0.0f) + maxf(spheres.y[j] - boxMax[1], 0.0f);
+			float dz = maxf(boxMin[2] - spheres.z[j], 0.0f) + maxf(spheres.z[j] - boxMax[2], 0.0f);
+			if (dx * dx + dy * dy + dz * dz <= spheres.radiusSq[j])
+				outIds.push_back(spheres.ids[j]);
+		}
+	}
+
+	/// <summary>
+	/// Finds the lights touching each cluster in slices [firstSlice, endSlice). The slice's lights are first
+	/// narrowed down to those touching each row of clusters, then each cluster in the row tests only those.
+	/// Offsets written to the grid are relative to outIndices.
+	/// </summary>
+	void LightClusters::binSlices(int firstSlice, int endSlice, std::vector<unsigned int>& outIndices)
+	{
+		SphereSet sliceSpheres, rowSpheres;
+		std::vector<unsigned int> rowIds;
+		for (int z = firstSlice; z < endSlice; z++)
+		{
+			sliceSpheres.build(m_sliceLights[z], m_viewPositions, m_radii);
+			for (int y = 0; y < m_gridY; y++)
+			{
+				//Union of the row's clusters
+				int first = clusterIndex(0, y, z);
+				int last = clusterIndex(m_gridX - 1, y, z);
+				float rowMin[3] = { m_minX[first], m_minY[first], m_minZ[first] };
+				float rowMax[3] = { m_maxX[last], m_maxY[first], m_maxZ[first] };
+				rowIds.clear();
+				appendOverlapping(rowMin, rowMax, sliceSpheres, rowIds);
+				rowSpheres.build(rowIds, m_viewPositions, m_radii);
+
+				for (int x = 0; x < m_gridX; x++)
+				{
+					int i = clusterIndex(x, y, z);
+					float boxMin[3] = { m_minX[i], m_minY[i], m_minZ[i] };
+					float boxMax[3] = { m_maxX[i], m_maxY[i], m_maxZ[i] };
+					unsigned int offset = (unsigned int)outIndices.size();
+					appendOverlapping(boxMin, boxMax, rowSpheres, outIndices);
+					m_grid[i * 2] = offset;
+					m_grid[i * 2 + 1] = (unsigned int)outIndices.size() - offset;
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Sends the grid and index list to the GPU. The index buffer grows by doubling when the list no longer fits.
+	/// </summary>
+	void LightClusters::upload()
+	{
+		if (!m_buffersValid) {
+			if (m_gridBuffer == 0)
+				glGenBuffers(1, &m_gridBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * m_grid.size(), NULL, GL_DYNAMIC_DRAW);
+			if (m_indexBuffer == 0)
+				glGenBuffers(1, &m_indexBuffer);
+			m_indexCapacity = m_indices.size() > 1024 ? m_indices.size() : 1024;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * m_indexCapacity, NULL, GL_DYNAMIC_DRAW);
+			m_buffersValid = true;
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int) * m_grid.size(), m_grid.data());
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer);
+		if (m_indices.size() > m_indexCapacity) {
+			m_indexCapacity = m_indexCapacity * 2 > m_indices.size() ? m_indexCapacity * 2 : m_indices.size();
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * m_indexCapacity, NULL, GL_DYNAMIC_DRAW);
+		}
+		if (!m_indices.empty())
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int) * m_indices.size(), m_indices.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void LightClusters::bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_GRID, m_gridBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_INDICES, m_indexBuffer);
+	}
+
+	/// <summary>
+	/// Values the shader needs to find a fragment's cluster. The slice is log(depth / near) * Z / log(far / near),
+	/// which the shader gets as log(depth) * sliceScale - sliceBias.
+	/// </summary>
+	ClusterUniforms LightClusters::getUniforms(float screenWidth, float screenHeight) const
+	{
+		ClusterUniforms uniforms;
+		uniforms.gridX = (unsigned int)m_gridX;
+		uniforms.gridY = (unsigned int)m_gridY;
+		uniforms.gridZ = (unsigned int)m_gridZ;
+		uniforms.pad0 = 0.0f;
+		uniforms.screenWidth = screenWidth;
+		uniforms.screenHeight = screenHeight;
+		float logRatio = logf(m_farPlane / m_nearPlane);
+		uniforms.sliceScale = m_gridZ / logRatio;
+		uniforms.sliceBias = m_gridZ * logf(m_nearPlane) / logRatio;
+		return uniforms;
+	}
+}
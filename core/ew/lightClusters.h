@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include "camera.h"
+#include "lightBuffer.h"
+#include "ewMath/vec3Stream.h"
+
+namespace ew {
+	//layout(std140) uniform ClusterBlock. Maps a fragment to its cluster:
+	//x = gl_FragCoord.x / screenWidth * gridX, slice z = floor(log(viewDepth) * sliceScale - sliceBias)
+	struct ClusterUniforms {
+		unsigned int gridX;
+		unsigned int gridY;
+		unsigned int gridZ;
+		float pad0;
+		float screenWidth;
+		float screenHeight;
+		float sliceScale;
+		float sliceBias;
+	};
+	static_assert(sizeof(ClusterUniforms) == 32, "ClusterUniforms must match std140");
+
+	//Clustered forward lighting. The view frustum is split into a grid of clusters, screen space tiles
+	//in x and y and exponentially spaced depth slices in z, and each cluster gets a list of the lights touching it.
+	//The GPU reads a uvec2(offset, count) per cluster from the grid buffer, and light indices from the index buffer.
+	//Those buffers are only created by the first upload(), so binning itself needs no GL context.
+	class LightClusters {
+	public:
+		LightClusters() {};
+		LightClusters(int gridX, int gridY, int gridZ);
+		void create(int gridX, int gridY, int gridZ);
+
+		//Bins lights into clusters for this camera. Depth slices are split across threadCount threads.
+		void update(const ew::Camera& camera, const PointLight* lights, int count, int threadCount = 1);
+		//Sends the grid and index list to the GPU, creating the buffers on the first call
+		void upload();
+		void bind()const;
+		ClusterUniforms getUniforms(float screenWidth, float screenHeight)const;
+
+		inline int getNumClusters()const { return m_gridX * m_gridY * m_gridZ; }
+		inline int getNumIndices()const { return (int)m_indices.size(); }
+		inline int getClusterLightCount(int x, int y, int z)const { return (int)m_grid[clusterIndex(x, y, z) * 2 + 1]; }
+		//getClusterLightCount() indices into the lights passed to update()
+		inline const unsigned int* getClusterLights(int x, int y, int z)const { return m_indices.data() + m_grid[clusterIndex(x, y, z) * 2]; }
+		//View space bounds of a cluster, as of the last update()
+		inline AABB getClusterBounds(int x, int y, int z)const {
+			int i = clusterIndex(x, y, z);
+			AABB box;
+			box.min = ew::Vec3(m_minX[i], m_minY[i], m_minZ[i]);
+			box.max = ew::Vec3(m_maxX[i], m_maxY[i], m_maxZ[i]);
+			return box;
+		}
+	private:
+		inline int clusterIndex(int x, int y, int z)const { return x + m_gridX * (y + m_gridY * z); }
+		void buildClusterBounds(const ew::Camera& camera);
+		void binSlices(int firstSlice, int endSlice, std::vector<unsigned int>& outIndices);
+
+		int m_gridX = 0, m_gridY = 0, m_gridZ = 0;
+		//View space cluster bounds, structure of arrays for testing 4 at a time
+		std::vector<float> m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
+		//Camera parameters the bounds were built for
+		ew::Camera m_boundsCamera;
+		bool m_boundsValid = false;
+		float m_nearPlane = 0.1f, m_farPlane = 100.0f;
+
+		//Per update scratch: view space lights, and the lights overlapping each depth slice
+		ew::Vec3Stream m_lightPositions, m_viewPositions;
+		std::vector<float> m_radii;
+		std::vector<std::vector<unsigned int>> m_sliceLights;
+
+		std::vector<unsigned int> m_grid; //Offset, count per cluster
+		std::vector<unsigned int> m_indices;
+		unsigned int m_gridBuffer = 0;
+		unsigned int m_indexBuffer = 0;
+		size_t m_indexCapacity = 0;
+		bool m_buffersValid = false; //False until upload() has sized the buffers for the current grid
+	};
+}
@@ -3,19 +3,65 @@
 */
 
 #include "mesh.h"
+#include <stdio.h>
+#include <algorithm>
 #include "ewMath/ewMath.h"
+#include "glStateCache.h"
+#include "instanceBuffer.h"
+#include "streamBuffer.h"
 #include "external/glad.h"
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
+	//Dirty ranges this many vertices apart or closer are uploaded together. Sending a few unchanged
+	//vertices costs less than another call.
+	static const int COALESCE_GAP_VERTICES = 32;
+	//Size of each region of the staging ring. Larger copies go through glBufferSubData instead.
+	static const size_t STAGING_BYTES_PER_REGION = 2 * 1024 * 1024;
+
+	static StreamBuffer& stagingBuffer()
+	{
+		static StreamBuffer staging(STAGING_BYTES_PER_REGION);
+		return staging;
+	}
+
+	const StreamBuffer& getMeshStagingBuffer()
 	{
-		load(meshData);
+		return stagingBuffer();
 	}
-	void Mesh::load(const MeshData& meshData)
+
+	/// <summary>
+	/// Writes data into the staging ring and has the GPU copy it into buffer. The copy is queued behind draws
+	/// still reading buffer instead of the CPU waiting for them, as glBufferSubData into a buffer in use may.
+	/// The ring only moves to its next region when the current one is full, so its fences cover every copy
+	/// made from that region.
+	/// </summary>
+	static void copyThroughStaging(unsigned int buffer, size_t offset, const void* data, size_t size)
+	{
+		StreamBuffer& staging = stagingBuffer();
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		if (size > staging.getRegionSize()) {
+			glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			return;
+		}
+		if (!staging.canAllocate(size, 4))
+			staging.beginFrame();
+		StreamRange range = staging.write(data, size, 4);
+		glBindBuffer(GL_COPY_READ_BUFFER, staging.getBuffer());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.offset, offset, size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	Mesh::Mesh(const MeshData& meshData, bool dynamic)
+	{
+		load(meshData, dynamic);
+	}
+	void Mesh::load(const MeshData& meshData, bool dynamic)
 	{
 		if (!m_initialized) {
 			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
+			ew::getGLStateCache().bindVertexArray(m_vao);
 
 			glGenBuffers(1, &m_vbo);
 			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
@@ -37,26 +83,91 @@ namespace ew {
 			m_initialized = true;
 		}
 
-		glBindVertexArray(m_vao);
+		ew::getGLStateCache().bindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		//Reloading data that fits reuses the existing storage, copied in through the staging ring so
+		//draws of the old data never have to finish first
+		int numVertices = (int)meshData.vertices.size();
+		int numIndices = (int)meshData.indices.size();
+		if (numVertices > m_vertexCapacity) {
+			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * numVertices, meshData.vertices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+			m_vertexCapacity = numVertices;
+		}
+		else if (numVertices > 0) {
+			copyThroughStaging(m_vbo, 0, meshData.vertices.data(), sizeof(Vertex) * numVertices);
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		if (numIndices > m_indexCapacity) {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * numIndices, meshData.indices.data(), GL_STATIC_DRAW);
+			m_indexCapacity = numIndices;
+		}
+		else if (numIndices > 0) {
+			copyThroughStaging(m_ebo, 0, meshData.indices.data(), sizeof(unsigned int) * numIndices);
 		}
 		m_numVertices = meshData.vertices.size();
 		m_numIndices = meshData.indices.size();
+		m_dynamic = dynamic;
+		if (dynamic)
+			m_vertices = meshData.vertices;
+		else
+			std::vector<Vertex>().swap(m_vertices);
+		m_dirtyRanges.clear();
+		m_bounds = meshData.vertices.empty() ? AABB() : ComputeAABB(&meshData.vertices[0].pos, meshData.vertices.size(), sizeof(Vertex));
 
-		glBindVertexArray(0);
+		ew::getGLStateCache().bindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
+	void Mesh::update(int firstVertex, const Vertex* vertices, int count)
+	{
+		if (!m_dynamic) {
+			printf("Mesh::update: mesh was not loaded as dynamic\n");
+			return;
+		}
+		if (firstVertex < 0 || count <= 0 || firstVertex + count > m_numVertices) {
+			printf("Mesh::update: vertices [%i, %i) out of range, mesh has %i\n", firstVertex, firstVertex + count, m_numVertices);
+			return;
+		}
+		std::copy(vertices, vertices + count, m_vertices.begin() + firstVertex);
+		DirtyRange range = { firstVertex, firstVertex + count };
+		m_dirtyRanges.push_back(range);
+	}
+
+	/// <summary>
+	/// Sorts the dirty ranges and merges the ones that overlap or are at most COALESCE_GAP_VERTICES apart,
+	/// then copies each merged range from the CPU copy through the staging ring. Bounds are recomputed
+	/// if anything changed.
+	/// </summary>
+	size_t Mesh::upload()
+	{
+		m_bytesUploaded = 0;
+		if (m_dirtyRanges.empty())
+			return 0;
+		std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end(), [](const DirtyRange& a, const DirtyRange& b) {
+			return a.begin < b.begin;
+		});
+		DirtyRange merged = m_dirtyRanges[0];
+		for (size_t i = 1; i <= m_dirtyRanges.size(); i++)
+		{
+			if (i < m_dirtyRanges.size() && m_dirtyRanges[i].begin <= merged.end + COALESCE_GAP_VERTICES) {
+				merged.end = std::max(merged.end, m_dirtyRanges[i].end);
+				continue;
+			}
+			size_t size = sizeof(Vertex) * (merged.end - merged.begin);
+			copyThroughStaging(m_vbo, sizeof(Vertex) * merged.begin, m_vertices.data() + merged.begin, size);
+			m_bytesUploaded += size;
+			if (i < m_dirtyRanges.size())
+				merged = m_dirtyRanges[i];
+		}
+		m_dirtyRanges.clear();
+		m_bounds = ComputeAABB(&m_vertices[0].pos, m_vertices.size(), sizeof(Vertex));
+		return m_bytesUploaded;
+	}
+
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
-		glBindVertexArray(m_vao);
+		ew::getGLStateCache().bindVertexArray(m_vao);
 		if (drawMode == DrawMode::TRIANGLES) {
 			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
 		}
@@ -65,4 +176,33 @@ namespace ew {
 		}
 		
 	}
+	void Mesh::drawInstanced(const InstanceBuffer& instances, ew::DrawMode drawMode) const
+	{
+		if (instances.getCount() <= 0)
+			return;
+		ew::getGLStateCache().bindVertexArray(m_vao);
+		if (!m_instancingEnabled) {
+			//One location per matrix column
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				unsigned int location = INSTANCE_ATTRIBUTE_MODEL + i;
+				glVertexAttribFormat(location, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + sizeof(ew::Vec4) * i);
+				glVertexAttribBinding(location, INSTANCE_BUFFER_BINDING);
+				glEnableVertexAttribArray(location);
+			}
+			glVertexAttribFormat(INSTANCE_ATTRIBUTE_COLOR, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, color));
+			glVertexAttribBinding(INSTANCE_ATTRIBUTE_COLOR, INSTANCE_BUFFER_BINDING);
+			glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_COLOR);
+			//Advance once per instance instead of once per vertex
+			glVertexBindingDivisor(INSTANCE_BUFFER_BINDING, 1);
+			m_instancingEnabled = true;
+		}
+		glBindVertexBuffer(INSTANCE_BUFFER_BINDING, instances.getBuffer(), instances.getOffset(), sizeof(InstanceData));
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL, instances.getCount());
+		}
+		else {
+			glDrawArraysInstanced(GL_POINTS, 0, m_numVertices, instances.getCount());
+		}
+	}
 }
\ No newline at end of file
@@ -3,7 +3,10 @@
 */
 
 #pragma once
+#include <vector>
+#include <stddef.h>
 #include "ewMath/ewMath.h"
+#include "bounds.h"
 
 namespace ew {
 	struct Vertex {
@@ -22,20 +25,59 @@ namespace ew {
 		POINTS = 1
 	};
 
+	class InstanceBuffer;
+	class StreamBuffer;
+
+	//Persistently mapped ring every Mesh copies reloaded and updated data through. Its fence waits show
+	//whether an update ever had to wait on the GPU.
+	const StreamBuffer& getMeshStagingBuffer();
+
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
-		void load(const MeshData& meshData);
+		Mesh(const MeshData& meshData, bool dynamic = false);
+		//A dynamic mesh keeps a CPU copy of its vertices for update(). Static meshes don't, to save memory.
+		void load(const MeshData& meshData, bool dynamic = false);
+		//Overwrites count vertices starting at firstVertex. Only a CPU copy changes, upload() sends the changes.
+		//Indices stay the same. The mesh must have been loaded as dynamic.
+		void update(int firstVertex, const Vertex* vertices, int count);
+		//Sends the vertices changed since the last upload, merging ranges that are close together
+		//into one copy. Returns the number of bytes sent.
+		size_t upload();
+		//Bytes sent by the last upload(), e.g. once per frame
+		inline size_t getNumBytesUploaded()const { return m_bytesUploaded; }
+		inline bool isDynamic()const { return m_dynamic; }
+		//CPU copy of the vertices, with changes from update(). Null unless the mesh is dynamic.
+		inline const Vertex* getVertices()const { return m_dynamic ? m_vertices.data() : nullptr; }
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Draws the mesh once per instance in one call. Shaders read the instances from
+		//INSTANCE_ATTRIBUTE_MODEL and INSTANCE_ATTRIBUTE_COLOR, see instanceBuffer.h.
+		void drawInstanced(const InstanceBuffer& instances, DrawMode drawMode = DrawMode::TRIANGLES)const;
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		//Object space bounds of the vertices passed to the last load()
+		inline const AABB& getBounds()const { return m_bounds; }
 	private:
 		bool m_initialized = false;
+		bool m_dynamic = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
 		int m_numVertices = 0;
 		int m_numIndices = 0;
+		int m_vertexCapacity = 0; //Size of the buffers' storage, in vertices and indices
+		int m_indexCapacity = 0;
+		//Instance attributes are only enabled once the VAO is drawn instanced, since an enabled attribute
+		//needs a buffer bound to read from
+		mutable bool m_instancingEnabled = false;
+		AABB m_bounds;
+		//Vertex range [begin, end) changed by update() and not uploaded yet
+		struct DirtyRange {
+			int begin;
+			int end;
+		};
+		std::vector<Vertex> m_vertices;
+		std::vector<DirtyRange> m_dirtyRanges;
+		size_t m_bytesUploaded = 0;
 	};
 }
\ No newline at end of file
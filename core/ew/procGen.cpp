@@ -7,27 +7,51 @@
 #include <stdlib.h>
 
 namespace ew {
+	//Normal and U/V axes of a cube face
+	struct CubeFace {
+		ew::Vec3 normal;
+		ew::Vec3 u;
+		ew::Vec3 v;
+	};
+	static constexpr CubeFace makeCubeFace(ew::Vec3 normal) {
+		ew::Vec3 u = ew::Vec3(normal.z, normal.x, normal.y);
+		return CubeFace{ normal, u, ew::Cross(normal, u) };
+	}
+	//Face axes are baked at compile time
+	static constexpr CubeFace CUBE_FACES[6] = {
+		makeCubeFace(ew::Vec3{ +0.0f,+0.0f,+1.0f }), //Front
+		makeCubeFace(ew::Vec3{ +1.0f,+0.0f,+0.0f }), //Right
+		makeCubeFace(ew::Vec3{ +0.0f,+1.0f,+0.0f }), //Top
+		makeCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }), //Left
+		makeCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }), //Bottom
+		makeCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }), //Back
+	};
+	static_assert(ew::Dot(CUBE_FACES[0].u, CUBE_FACES[0].normal) == 0.0f, "Cube face U axis must be perpendicular to its normal");
+	static_assert(ew::Dot(CUBE_FACES[3].v, CUBE_FACES[3].normal) == 0.0f, "Cube face V axis must be perpendicular to its normal");
+	static_assert(ew::Cross(CUBE_FACES[2].u, CUBE_FACES[2].v).y == 1.0f, "Cube face winding must face outwards");
+	static_assert(ew::Cross(CUBE_FACES[5].u, CUBE_FACES[5].v).z == -1.0f, "Cube face winding must face outwards");
+
 	/// <summary>
 	/// Helper function for createCube. Note that this is not meant to be used standalone
 	/// </summary>
-	/// <param name="normal">Normal direction of the face</param>
+	/// <param name="face">Normal and axes of the face</param>
 	/// <param name="size">Width/height of the face</param>
 	/// <param name="mesh">MeshData struct to fill</param>
-	static void createCubeFace(ew::Vec3 normal, float size, MeshData* mesh) {
+	static void createCubeFace(const CubeFace& face, float size, MeshData* mesh) {
 		unsigned int startVertex = mesh->vertices.size();
-		ew::Vec3 a = ew::Vec3(normal.z, normal.x, normal.y); //U axis
-		ew::Vec3 b = ew::Cross(normal, a); //V axis
+		const ew::Vec3& a = face.u; //U axis
+		const ew::Vec3& b = face.v; //V axis
 		for (int i = 0; i < 4; i++)
 		{
 			int col = i % 2;
 			int row = i / 2;
 
-			ew::Vec3 pos = normal * size * 0.5f;
+			ew::Vec3 pos = face.normal * size * 0.5f;
 			pos -= (a + b) * size * 0.5f;
 			pos += (a * col + b * row) * size;
 			Vertex vertex;// = &mesh->vertices[mesh->vertices.size()];
 			vertex.pos = pos;
-			vertex.normal = normal;
+			vertex.normal = face.normal;
 			vertex.uv = ew::Vec2(col, row);
 			mesh->vertices.push_back(vertex);
 		}
@@ -49,12 +73,8 @@ namespace ew {
 		MeshData mesh;
 		mesh.vertices.reserve(24); //6 x 4 vertices
 		mesh.indices.reserve(36); //6 x 6 indices
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,+1.0f }, size, &mesh); //Front
-		createCubeFace(ew::Vec3{ +1.0f,+0.0f,+0.0f }, size, &mesh); //Right
-		createCubeFace(ew::Vec3{ +0.0f,+1.0f,+0.0f }, size, &mesh); //Top
-		createCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
-		createCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		for (const CubeFace& face : CUBE_FACES)
+			createCubeFace(face, size, &mesh);
 		return mesh;
 	}
 	MeshData createPlane(float width, float height, int subdivisions)
@@ -0,0 +1,180 @@
+#include "programCache.h"
+#include <stdio.h>
+#include <vector>
+#include "shader.h"
+#include "external/glad.h"
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace ew {
+	static std::string s_cacheDirectory = "shaderCache";
+
+	static const uint32_t CACHE_FILE_MAGIC = 0x42505745; //"EWPB"
+	//Bump whenever the file layout changes, so old cache files are ignored
+	static const uint32_t CACHE_FILE_VERSION = 1;
+
+	struct CacheFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	void setProgramCacheDirectory(const std::string& directory)
+	{
+		s_cacheDirectory = directory;
+	}
+
+	const std::string& getProgramCacheDirectory()
+	{
+		return s_cacheDirectory;
+	}
+
+	bool isProgramCacheEnabled()
+	{
+		if (s_cacheDirectory.empty())
+			return false;
+		int numBinaryFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+		return numBinaryFormats > 0;
+	}
+
+	static uint64_t fnv1a(uint64_t hash, const char* str) {
+		if (str == NULL)
+			return hash;
+		for (; *str != '\0'; str++) {
+			hash ^= (unsigned char)*str;
+			hash *= 0x100000001b3ull;
+		}
+		//Hash the terminator too, so "ab" + "c" and "a" + "bc" differ
+		hash *= 0x100000001b3ull;
+		return hash;
+	}
+
+	/// <summary>
+	/// Hashes everything a program binary depends on. Binaries are only valid for the exact driver
+	/// that produced them, so its strings are part of the key.
+	/// </summary>
+	uint64_t hashProgramSources(const char* vertexShaderSource, const char* fragmentShaderSource)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		hash = fnv1a(hash, (const char*)glGetString(GL_VENDOR));
+		hash = fnv1a(hash, (const char*)glGetString(GL_RENDERER));
+		hash = fnv1a(hash, (const char*)glGetString(GL_VERSION));
+		hash = fnv1a(hash, vertexShaderSource);
+		hash = fnv1a(hash, fragmentShaderSource);
+		return hash;
+	}
+
+	static std::string cacheFilePath(uint64_t key) {
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)key);
+		return s_cacheDirectory + "/" + fileName;
+	}
+
+	/// <summary>
+	/// Creates a program from a cached binary
+	/// </summary>
+	/// <returns>0 if there is no cache file for this key or the driver rejected the binary</returns>
+	unsigned int loadCachedProgram(uint64_t key)
+	{
+		FILE* file = fopen(cacheFilePath(key).c_str(), "rb");
+		if (file == NULL)
+			return 0;
+		CacheFileHeader header;
+		std::vector<unsigned char> binary;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1
+			&& header.magic == CACHE_FILE_MAGIC && header.version == CACHE_FILE_VERSION && header.key == key;
+		//The length comes from disk, so a truncated or corrupt file must not decide how much is allocated
+		if (valid) {
+			long binaryStart = ftell(file);
+			valid = binaryStart >= 0 && fseek(file, 0, SEEK_END) == 0;
+			long fileSize = valid ? ftell(file) : -1;
+			valid = valid && fileSize >= binaryStart && header.binaryLength > 0
+				&& (unsigned long)header.binaryLength <= (unsigned long)(fileSize - binaryStart)
+				&& fseek(file, binaryStart, SEEK_SET) == 0;
+		}
+		if (valid) {
+			binary.resize(header.binaryLength);
+			valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+		}
+		fclose(file);
+		if (!valid)
+			return 0;
+
+		unsigned int program = glCreateProgram();
+		glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+		//Drivers may reject binaries from other versions of themselves even if the strings match
+		int success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	void storeCachedProgram(uint64_t key, unsigned int program)
+	{
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+		std::vector<unsigned char> binary(length);
+		CacheFileHeader header;
+		header.magic = CACHE_FILE_MAGIC;
+		header.version = CACHE_FILE_VERSION;
+		header.key = key;
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		header.binaryFormat = format;
+		header.binaryLength = (uint32_t)length;
+
+#if defined(_WIN32)
+		_mkdir(s_cacheDirectory.c_str());
+#else
+		mkdir(s_cacheDirectory.c_str(), 0755);
+#endif
+		FILE* file = fopen(cacheFilePath(key).c_str(), "wb");
+		if (file == NULL) {
+			printf("Failed to write program cache file %s\n", cacheFilePath(key).c_str());
+			return;
+		}
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(binary.data(), 1, header.binaryLength, file);
+		fclose(file);
+	}
+
+	void removeCachedProgram(uint64_t key)
+	{
+		remove(cacheFilePath(key).c_str());
+	}
+
+	/// <summary>
+	/// Creates a shader program, going through the program binary cache when the driver supports it
+	/// </summary>
+	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
+	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <returns></returns>
+	unsigned int createShaderProgramCached(const char* vertexShaderSource, const char* fragmentShaderSource)
+	{
+		if (!isProgramCacheEnabled())
+			return createShaderProgram(vertexShaderSource, fragmentShaderSource);
+
+		uint64_t key = hashProgramSources(vertexShaderSource, fragmentShaderSource);
+		unsigned int program = loadCachedProgram(key);
+		if (program != 0)
+			return program;
+
+		program = createShaderProgram(vertexShaderSource, fragmentShaderSource, true);
+		int success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (success)
+			storeCachedProgram(key, program);
+		return program;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+
+namespace ew {
+	//On-disk cache of linked program binaries, so shaders only compile the first time the app runs on a driver.
+	//Entries are keyed by the GLSL source and the driver vendor/renderer/version, so editing a shader or
+	//updating the driver just misses the cache and compiles from source.
+
+	//Directory the cache is read from and written to, relative to the working directory. Empty disables the cache.
+	void setProgramCacheDirectory(const std::string& directory);
+	const std::string& getProgramCacheDirectory();
+
+	//False if the directory is empty or the driver has no program binary formats
+	bool isProgramCacheEnabled();
+
+	//FNV-1a hash of the program sources and the current driver strings. Needs a current GL context.
+	uint64_t hashProgramSources(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+	//Creates a program from the binary cached under key. Returns 0 on a miss or if the driver rejects the binary.
+	unsigned int loadCachedProgram(uint64_t key);
+	//Writes a linked program's binary to the cache. Link it with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	void storeCachedProgram(uint64_t key, unsigned int program);
+	//Deletes the binary cached under key, so the next createShaderProgramCached compiles from source
+	void removeCachedProgram(uint64_t key);
+
+	//Loads the program from the cache if there is a matching binary the driver accepts,
+	//otherwise compiles it with createShaderProgram and stores the binary for next time
+	unsigned int createShaderProgramCached(const char* vertexShaderSource, const char* fragmentShaderSource);
+}
@@ -0,0 +1,152 @@
+#include "renderQueue.h"
+#include <string.h>
+#include "glStateCache.h"
+#include "external/glad.h"
+
+namespace ew {
+	static const int DEPTH_BITS = 24;
+	static const uint64_t DEPTH_MAX = (1ull << DEPTH_BITS) - 1;
+	static const RenderMaterial s_defaultMaterial;
+
+	//Folds a pointer into a few bits. Objects sit at least a few bytes apart, so the low bits are dropped.
+	static uint64_t pointerBits(const void* pointer, int bits) {
+		uint64_t value = (uint64_t)(uintptr_t)pointer >> 4;
+		value ^= value >> 17;
+		value *= 0x9E3779B97F4A7C15ull;
+		return value >> (64 - bits);
+	}
+
+	void RenderQueue::begin(const Camera& camera)
+	{
+		m_items.clear();
+		m_entries.clear();
+		m_cameraPosition = camera.position;
+		m_cameraForward = ew::Normalize(camera.target - camera.position);
+		m_farPlane = camera.farPlane > 0.0f ? camera.farPlane : 1.0f;
+	}
+
+	/// <summary>
+	/// Builds the item's sort key. The item is copied, so it can be reused for the next submit.
+	/// </summary>
+	void RenderQueue::submit(const RenderItem& item)
+	{
+		const RenderMaterial* material = item.material != nullptr ? item.material : &s_defaultMaterial;
+		ew::Vec3 position = ew::Vec3(item.model[3].x, item.model[3].y, item.model[3].z);
+		float depth = ew::Dot(position - m_cameraPosition, m_cameraForward) / m_farPlane;
+		//Written so NaN, from a camera looking at its own position, ends up as 0
+		depth = depth > 0.0f ? (depth < 1.0f ? depth : 1.0f) : 0.0f;
+		uint64_t depthBits = (uint64_t)(depth * DEPTH_MAX);
+		uint64_t shaderBits = item.shader->getProgram() & 0xFFF;
+		uint64_t materialBits = pointerBits(material, 12);
+		uint64_t meshBits = pointerBits(item.mesh, 14);
+
+		SortEntry entry;
+		if (material->transparent)
+			entry.key = (1ull << 62) | ((DEPTH_MAX - depthBits) << 38) | (shaderBits << 26) | (materialBits << 14) | meshBits;
+		else
+			entry.key = (shaderBits << 50) | (materialBits << 38) | (meshBits << 24) | depthBits;
+		entry.index = (uint32_t)m_items.size();
+		m_entries.push_back(entry);
+		m_items.push_back(item);
+		m_items.back().material = material;
+	}
+
+	/// <summary>
+	/// LSD radix sort, 8 bits per pass. All histograms are built in one read of the keys, and passes where
+	/// every key has the same byte are skipped, which is common for the pass and shader bytes.
+	/// Stable, so draws with equal keys keep their submit order.
+	/// </summary>
+	void RenderQueue::sort()
+	{
+		size_t count = m_entries.size();
+		if (count < 2)
+			return;
+		uint32_t histograms[8][256];
+		memset(histograms, 0, sizeof(histograms));
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t key = m_entries[i].key;
+			for (int b = 0; b < 8; b++)
+				histograms[b][(key >> (b * 8)) & 0xFF]++;
+		}
+		m_scratch.resize(count);
+		SortEntry* source = m_entries.data();
+		SortEntry* destination = m_scratch.data();
+		for (int b = 0; b < 8; b++)
+		{
+			uint32_t* histogram = histograms[b];
+			if (histogram[(source[0].key >> (b * 8)) & 0xFF] == count)
+				continue;
+			uint32_t offset = 0;
+			for (int i = 0; i < 256; i++)
+			{
+				uint32_t bucketSize = histogram[i];
+				histogram[i] = offset;
+				offset += bucketSize;
+			}
+			for (size_t i = 0; i < count; i++)
+				destination[histogram[(source[i].key >> (b * 8)) & 0xFF]++] = source[i];
+			SortEntry* swap = source;
+			source = destination;
+			destination = swap;
+		}
+		if (source != m_entries.data())
+			m_entries.swap(m_scratch);
+	}
+
+	/// <summary>
+	/// Executes the sorted draws. Each program, material and blend state is only set when it differs
+	/// from the previous draw's. Leaves blending off and depth writes on.
+	/// </summary>
+	void RenderQueue::draw()
+	{
+		sort();
+		GLStateCache& glState = ew::getGLStateCache();
+		m_numStateChanges = 0;
+		const Shader* shader = nullptr;
+		const RenderMaterial* material = nullptr;
+		const Mesh* mesh = nullptr;
+		int transparent = -1;
+		UniformHandle modelUniform, normalMatrixUniform, colorUniform;
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			const RenderItem& item = m_items[m_entries[i].index];
+			if ((int)item.material->transparent != transparent) {
+				transparent = item.material->transparent;
+				glState.setEnabled(GL_BLEND, item.material->transparent);
+				glState.depthMask(!item.material->transparent);
+				if (item.material->transparent)
+					glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+			if (item.shader != shader) {
+				shader = item.shader;
+				shader->use();
+				modelUniform = shader->getUniform("_Model");
+				normalMatrixUniform = shader->getUniform("_NormalMatrix");
+				colorUniform = shader->getUniform("_Color");
+				m_numStateChanges++;
+			}
+			if (item.material != material) {
+				material = item.material;
+				//Empty slots are unbound too, so a material never samples the previous material's texture.
+				//Units that are already empty are skipped by the cache.
+				for (int t = 0; t < RenderMaterial::MAX_TEXTURES; t++)
+					glState.bindTexture(t, GL_TEXTURE_2D, material->textures[t]);
+				m_numStateChanges++;
+			}
+			if (item.mesh != mesh) {
+				mesh = item.mesh;
+				m_numStateChanges++;
+			}
+			if (modelUniform.isValid())
+				shader->setMat4(modelUniform, item.model);
+			if (normalMatrixUniform.isValid())
+				shader->setMat4(normalMatrixUniform, item.normalMatrix);
+			if (colorUniform.isValid())
+				shader->setVec3(colorUniform, item.color);
+			mesh->draw();
+		}
+		glState.disable(GL_BLEND);
+		glState.depthMask(true);
+	}
+}
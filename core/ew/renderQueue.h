@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "ewMath/ewMath.h"
+#include "shader.h"
+#include "mesh.h"
+#include "camera.h"
+
+namespace ew {
+	//State shared by the draws of one material
+	struct RenderMaterial {
+		static const int MAX_TEXTURES = 4;
+		unsigned int textures[MAX_TEXTURES] = {}; //2D textures bound to units 0 and up, 0 unbinds the unit
+		bool transparent = false; //Alpha blended, drawn after every opaque draw without writing depth
+	};
+
+	//One draw submitted to a RenderQueue. Uniforms the shader doesn't have are skipped.
+	struct RenderItem {
+		const Shader* shader = nullptr;
+		const Mesh* mesh = nullptr;
+		const RenderMaterial* material = nullptr;
+		ew::Mat4 model = ew::IdentityMatrix(); //_Model
+		ew::Mat4 normalMatrix = ew::IdentityMatrix(); //_NormalMatrix
+		ew::Vec3 color = ew::Vec3(1.0f); //_Color
+	};
+
+	//Collects a frame's draws and executes them sorted, so programs, textures and VAOs change as rarely as possible.
+	//Each draw gets a 64 bit key, most significant field first:
+	//opaque:      pass(2) shader(12) material(12) mesh(14) depth(24), front to back within a state bucket for early-Z
+	//transparent: pass(2) inverted depth(24) shader(12) material(12) mesh(14), back to front so blending is correct
+	//Ids in the key are hashes, collisions only cost an extra state change, never a wrong draw.
+	class RenderQueue {
+	public:
+		RenderQueue() {};
+
+		//Clears last frame's draws. Depth is distance along the camera's view direction.
+		void begin(const Camera& camera);
+		void submit(const RenderItem& item);
+		//Radix sorts the keys and draws everything through the GLStateCache
+		void draw();
+
+		inline int getNumDraws()const { return (int)m_items.size(); }
+		//Program, material and mesh switches in the last draw()
+		inline int getNumStateChanges()const { return m_numStateChanges; }
+	private:
+		struct SortEntry {
+			uint64_t key;
+			uint32_t index;
+		};
+		void sort();
+
+		std::vector<RenderItem> m_items;
+		std::vector<SortEntry> m_entries;
+		std::vector<SortEntry> m_scratch;
+		ew::Vec3 m_cameraPosition;
+		ew::Vec3 m_cameraForward;
+		float m_farPlane = 100.0f;
+		int m_numStateChanges = 0;
+	};
+}
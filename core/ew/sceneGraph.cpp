@@ -0,0 +1,124 @@
+#include "sceneGraph.h"
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <stdio.h>
+
+namespace ew {
+	//Below this many nodes, spawning threads costs more than it saves
+	static const int MIN_NODES_FOR_THREADING = 4096;
+
+	/// <summary>
+	/// Adds a node to the graph
+	/// </summary>
+	/// <param name="localTransform">Transform relative to the parent</param>
+	/// <param name="parent">Index of an existing node, or SCENE_NO_PARENT for a root</param>
+	/// <returns>Index of the new node</returns>
+	int SceneGraph::addNode(const Transform& localTransform, int parent)
+	{
+		int node = getNumNodes();
+		if (parent < SCENE_NO_PARENT || parent >= node) {
+			printf("SceneGraph: parent %i does not exist yet, adding node %i as a root\n", parent, node);
+			parent = SCENE_NO_PARENT;
+		}
+		m_localTransforms.push_back(localTransform);
+		m_parents.push_back(parent);
+		m_worldMatrices.push_back(ew::IdentityMatrix());
+		m_dirty.push_back(1);
+		m_updated.push_back(0);
+
+		int subtree;
+		if (parent == SCENE_NO_PARENT) {
+			subtree = (int)m_subtreeNodes.size();
+			m_subtreeNodes.emplace_back();
+			m_subtreeDirty.push_back(1);
+		}
+		else {
+			subtree = m_subtreeOf[parent];
+		}
+		m_subtreeOf.push_back(subtree);
+		m_subtreeNodes[subtree].push_back(node);
+		m_subtreeDirty[subtree] = 1;
+		return node;
+	}
+
+	void SceneGraph::setLocalTransform(int node, const Transform& localTransform)
+	{
+		m_localTransforms[node] = localTransform;
+		m_dirty[node] = 1;
+		m_subtreeDirty[m_subtreeOf[node]] = 1;
+	}
+
+	/// <summary>
+	/// Walks one root subtree in index order. A node is recomputed if it was changed or its parent was recomputed.
+	/// </summary>
+	void SceneGraph::updateSubtree(int subtree)
+	{
+		for (int node : m_subtreeNodes[subtree])
+		{
+			int parent = m_parents[node];
+			bool changed = m_dirty[node] || (parent != SCENE_NO_PARENT && m_updated[parent]);
+			m_updated[node] = changed;
+			if (!changed)
+				continue;
+			ew::Mat4 local = m_localTransforms[node].getModelMatrix();
+			m_worldMatrices[node] = parent == SCENE_NO_PARENT ? local : m_worldMatrices[parent] * local;
+			m_dirty[node] = 0;
+		}
+		m_subtreeDirty[subtree] = 0;
+	}
+
+	/// <summary>
+	/// Propagates world matrices through every subtree that has changed since the last update
+	/// </summary>
+	/// <param name="threadCount">Max number of threads to use, including the calling thread</param>
+	void SceneGraph::update(int threadCount)
+	{
+		std::vector<int> dirtySubtrees;
+		int dirtyNodes = 0;
+		for (int i = 0; i < (int)m_subtreeNodes.size(); i++)
+		{
+			if (m_subtreeDirty[i]) {
+				dirtySubtrees.push_back(i);
+				dirtyNodes += (int)m_subtreeNodes[i].size();
+			}
+			else {
+				//Clean subtrees are skipped entirely, but their flags from the previous update must be cleared
+				for (int node : m_subtreeNodes[i])
+					m_updated[node] = 0;
+			}
+		}
+
+		int numThreads = std::min(threadCount, (int)dirtySubtrees.size());
+		if (numThreads <= 1 || dirtyNodes < MIN_NODES_FOR_THREADING) {
+			for (int subtree : dirtySubtrees)
+				updateSubtree(subtree);
+			return;
+		}
+
+		//Largest subtrees first, each assigned to the thread with the least work so far
+		std::sort(dirtySubtrees.begin(), dirtySubtrees.end(), [this](int a, int b) {
+			return m_subtreeNodes[a].size() > m_subtreeNodes[b].size();
+		});
+		std::vector<std::vector<int>> work(numThreads);
+		std::vector<size_t> load(numThreads, 0);
+		for (int subtree : dirtySubtrees)
+		{
+			int t = (int)(std::min_element(load.begin(), load.end()) - load.begin());
+			work[t].push_back(subtree);
+			load[t] += m_subtreeNodes[subtree].size();
+		}
+
+		auto runWork = [this](const std::vector<int>& subtrees) {
+			for (int subtree : subtrees)
+				updateSubtree(subtree);
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(numThreads - 1);
+		for (int t = 1; t < numThreads; t++)
+			workers.emplace_back(runWork, std::cref(work[t]));
+		runWork(work[0]);
+		for (auto& worker : workers)
+			worker.join();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "transform.h"
+
+namespace ew {
+	const int SCENE_NO_PARENT = -1;
+
+	//Flat transform hierarchy. Nodes are stored in the order they were added, and a parent must exist before
+	//its children, so the array is always topologically sorted. Nodes are identified by their index.
+	class SceneGraph {
+	public:
+		int addNode(const Transform& localTransform, int parent = SCENE_NO_PARENT);
+		inline int getNumNodes()const { return (int)m_parents.size(); }
+		inline int getParent(int node)const { return m_parents[node]; }
+
+		inline const Transform& getLocalTransform(int node)const { return m_localTransforms[node]; }
+		void setLocalTransform(int node, const Transform& localTransform);
+
+		//Only valid after update()
+		inline const ew::Mat4& getWorldMatrix(int node)const { return m_worldMatrices[node]; }
+		//True if the node's world matrix changed in the last update()
+		inline bool wasUpdated(int node)const { return m_updated[node] != 0; }
+
+		//Recomputes world matrices of changed nodes and their descendants.
+		//Independent root subtrees are split across threadCount threads.
+		void update(int threadCount = 1);
+	private:
+		void updateSubtree(int subtree);
+
+		std::vector<Transform> m_localTransforms;
+		std::vector<int> m_parents;
+		std::vector<ew::Mat4> m_worldMatrices;
+		std::vector<unsigned char> m_dirty; //Local transform changed since last update
+		std::vector<unsigned char> m_updated; //World matrix changed during last update
+
+		//Nodes grouped by their root ancestor, each group in ascending index order
+		std::vector<int> m_subtreeOf;
+		std::vector<std::vector<int>> m_subtreeNodes;
+		std::vector<unsigned char> m_subtreeDirty;
+	};
+}
@@ -1,4 +1,7 @@
 #include "shader.h"
+#include "programCache.h"
+#include "shaderPreprocessor.h"
+#include "glStateCache.h"
 #include <fstream>
 #include <sstream>
 #include "external/glad.h"
@@ -49,8 +52,9 @@ namespace ew {
 	/// </summary>
 	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
 	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <param name="binaryRetrievable">Hint to the driver that the linked binary will be read back</param>
 	/// <returns></returns>
-	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, bool binaryRetrievable) {
 		unsigned int vertexShader = createShader(GL_VERTEX_SHADER, vertexShaderSource);
 		unsigned int fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
 
@@ -58,6 +62,8 @@ namespace ew {
 		//Attach each stage
 		glAttachShader(shaderProgram, vertexShader);
 		glAttachShader(shaderProgram, fragmentShader);
+		if (binaryRetrievable)
+			glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		//Link all the stages together
 		glLinkProgram(shaderProgram);
 		int success;
@@ -73,31 +79,137 @@ namespace ew {
 		return shaderProgram;
 	}
 	/// <summary>
-	/// Creates a shader instance with vertex + fragment stages
+	/// Creates a shader instance with vertex + fragment stages. Uses a cached program binary when one matches.
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
 	/// <param name="fragmentShader">File path to fragment shader</param>
-	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader)
+	/// <param name="defines">Injected after #version in both stages</param>
+	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines)
 	{
-		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
-		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
-		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_vertexShader = vertexShader;
+		m_fragmentShader = fragmentShader;
+		m_defines = defines;
+		ShaderSource vertexSource = ew::preprocessShader(vertexShader, defines);
+		ShaderSource fragmentSource = ew::preprocessShader(fragmentShader, defines);
+		m_dependencies = vertexSource.dependencies;
+		m_dependencies.insert(m_dependencies.end(), fragmentSource.dependencies.begin(), fragmentSource.dependencies.end());
+		m_id = ew::createShaderProgramCached(vertexSource.code.c_str(), fragmentSource.code.c_str());
+		reflectUniforms();
+	}
+	Shader::Shader(unsigned int programId)
+	{
+		m_id = programId;
+		reflectUniforms();
+	}
+	/// <summary>
+	/// Compiles the shader's files again. Blocks until done, ShaderLibrary reloads in the background instead.
+	/// </summary>
+	bool Shader::reload()
+	{
+		if (m_vertexShader.empty())
+			return false;
+		ShaderSource vertexSource = ew::preprocessShader(m_vertexShader, m_defines);
+		ShaderSource fragmentSource = ew::preprocessShader(m_fragmentShader, m_defines);
+		if (!vertexSource.valid || !fragmentSource.valid)
+			return false;
+		unsigned int program = ew::createShaderProgramCached(vertexSource.code.c_str(), fragmentSource.code.c_str());
+		int success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(program);
+			return false;
+		}
+		ew::getGLStateCache().forgetProgram(m_id);
+		glDeleteProgram(m_id);
+		m_id = program;
+		m_dependencies = vertexSource.dependencies;
+		m_dependencies.insert(m_dependencies.end(), fragmentSource.dependencies.begin(), fragmentSource.dependencies.end());
+		reflectUniforms();
+		return true;
+	}
+	/// <summary>
+	/// Caches the location of every active uniform so setters never have to ask the driver.
+	/// Arrays are stored under both "name" and each "name[i]".
+	/// </summary>
+	void Shader::reflectUniforms()
+	{
+		m_uniformLocations.clear();
+		int numUniforms = 0, maxNameLength = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::string name(maxNameLength, '\0');
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int nameLength = 0, size = 0;
+			GLenum type;
+			glGetActiveUniform(m_id, i, maxNameLength, &nameLength, &size, &type, &name[0]);
+			std::string uniformName = name.substr(0, nameLength);
+			int location = glGetUniformLocation(m_id, uniformName.c_str());
+			//Uniform block members have no location
+			if (location < 0)
+				continue;
+			m_uniformLocations[uniformName] = location;
+			//Arrays of basic types are reported once as "name[0]", elements have consecutive locations
+			if (size > 1 || uniformName.back() == ']') {
+				std::string baseName = uniformName.substr(0, uniformName.rfind('['));
+				m_uniformLocations[baseName] = location;
+				for (int element = 0; element < size; element++)
+					m_uniformLocations[baseName + "[" + std::to_string(element) + "]"] = location + element;
+			}
+		}
 	}
 	void Shader::use()const
 	{
-		glUseProgram(m_id);
+		ew::getGLStateCache().useProgram(m_id);
+	}
+	/// <summary>
+	/// Looks up a uniform in the reflected uniforms
+	/// </summary>
+	/// <param name="name">Full uniform name, e.g. "_Lights[2].color"</param>
+	/// <returns>Invalid handle if the uniform is not active in this program</returns>
+	UniformHandle Shader::getUniform(const std::string& name) const
+	{
+		UniformHandle handle;
+		auto it = m_uniformLocations.find(name);
+		if (it != m_uniformLocations.end())
+			handle.location = it->second;
+		return handle;
+	}
+	/// <summary>
+	/// Assigns a binding index to a uniform block. Blocks the program doesn't use are ignored.
+	/// </summary>
+	/// <param name="blockName">Block name as declared in GLSL, e.g. "CameraBlock"</param>
+	/// <param name="binding">Index later passed to glBindBufferRange / UniformBuffer::bind</param>
+	void Shader::bindUniformBlock(const std::string& blockName, unsigned int binding) const
+	{
+		unsigned int blockIndex = glGetUniformBlockIndex(m_id, blockName.c_str());
+		if (blockIndex == GL_INVALID_INDEX)
+			return;
+		glUniformBlockBinding(m_id, blockIndex, binding);
+	}
+	/// <summary>
+	/// Assigns a binding index to a shader storage block. Blocks the program doesn't use are ignored.
+	/// </summary>
+	/// <param name="blockName">Block name as declared in GLSL, e.g. "LightBlock"</param>
+	/// <param name="binding">Index later passed to glBindBufferBase / LightBuffer::bind</param>
+	void Shader::bindStorageBlock(const std::string& blockName, unsigned int binding) const
+	{
+		unsigned int blockIndex = glGetProgramResourceIndex(m_id, GL_SHADER_STORAGE_BLOCK, blockName.c_str());
+		if (blockIndex == GL_INVALID_INDEX)
+			return;
+		glShaderStorageBlockBinding(m_id, blockIndex, binding);
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1i(getUniform(name).location, v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1f(getUniform(name).location, v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		glUniform2f(getUniform(name).location, x, y);
 	}
 	void Shader::setVec2(const std::string& name, const ew::Vec2& v) const
 	{
@@ -105,7 +217,7 @@ namespace ew {
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		glUniform3f(getUniform(name).location, x, y, z);
 	}
 	void Shader::setVec3(const std::string& name, const ew::Vec3& v) const
 	{
@@ -113,7 +225,7 @@ namespace ew {
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		glUniform4f(getUniform(name).location, x, y, z, w);
 	}
 	void Shader::setVec4(const std::string& name, const ew::Vec4& v) const
 	{
@@ -121,7 +233,30 @@ namespace ew {
 	}
 	void Shader::setMat4(const std::string& name, const ew::Mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &m[0][0]);
+		glUniformMatrix4fv(getUniform(name).location, 1, GL_FALSE, &m[0][0]);
 	}
-}
-
+	void Shader::setInt(UniformHandle handle, int v) const
+	{
+		glUniform1i(handle.location, v);
+	}
+	void Shader::setFloat(UniformHandle handle, float v) const
+	{
+		glUniform1f(handle.location, v);
+	}
+	void Shader::setVec2(UniformHandle handle, const ew::Vec2& v) const
+	{
+		glUniform2f(handle.location, v.x, v.y);
+	}
+	void Shader::setVec3(UniformHandle handle, const ew::Vec3& v) const
+	{
+		glUniform3f(handle.location, v.x, v.y, v.z);
+	}
+	void Shader::setVec4(UniformHandle handle, const ew::Vec4& v) const
+	{
+		glUniform4f(handle.location, v.x, v.y, v.z, v.w);
+	}
+	void Shader::setMat4(UniformHandle handle, const ew::Mat4& m) const
+	{
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, &m[0][0]);
+	}
+}
\ No newline at end of file
@@ -1,14 +1,39 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "ewMath/ewMath.h"
 
 namespace ew {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
-	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+	//binaryRetrievable lets glGetProgramBinary be used on the result, see programCache.h
+	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, bool binaryRetrievable = false);
+	//Resolved uniform location. Setting an invalid handle is a no-op, like a uniform the compiler optimized out.
+	struct UniformHandle {
+		int location = -1;
+		inline bool isValid()const { return location >= 0; }
+	};
+
 	class Shader {
 	public:
-		Shader(const std::string& vertexShader, const std::string& fragmentShader);
+		Shader() {};
+		//Files may #include others, see preprocessShader
+		Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines = {});
+		//Takes ownership of an already linked program, e.g. one compiled by ShaderLibrary
+		explicit Shader(unsigned int programId);
 		void use()const;
+		inline unsigned int getProgram()const { return m_id; }
+		//Recompiles from the files the shader was created from, keeping the old program if that fails.
+		//Returns true if the program was replaced, after which uniform handles and block bindings must be set up again.
+		bool reload();
+		//Every file the program was built from, including includes
+		inline const std::vector<std::string>& getDependencies()const { return m_dependencies; }
+		//Resolve once outside of hot loops, then upload with the handle overloads below
+		UniformHandle getUniform(const std::string& name) const;
+		//Points a uniform block in this program at a binding index, e.g. UNIFORM_BINDING_CAMERA
+		void bindUniformBlock(const std::string& blockName, unsigned int binding) const;
+		//Points a shader storage block in this program at a binding index, e.g. STORAGE_BINDING_LIGHTS
+		void bindStorageBlock(const std::string& blockName, unsigned int binding) const;
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
 		void setVec2(const std::string& name, float x, float y) const;
@@ -18,7 +43,20 @@ namespace ew {
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void setVec4(const std::string& name, const ew::Vec4& v) const;
 		void setMat4(const std::string& name, const ew::Mat4& m) const;
+
+		void setInt(UniformHandle handle, int v) const;
+		void setFloat(UniformHandle handle, float v) const;
+		void setVec2(UniformHandle handle, const ew::Vec2& v) const;
+		void setVec3(UniformHandle handle, const ew::Vec3& v) const;
+		void setVec4(UniformHandle handle, const ew::Vec4& v) const;
+		void setMat4(UniformHandle handle, const ew::Mat4& m) const;
 	private:
-		unsigned int m_id; //Shader program handle
+		void reflectUniforms();
+
+		unsigned int m_id = 0; //Shader program handle
+		std::unordered_map<std::string, int> m_uniformLocations; //Every active uniform, filled after linking
+		std::string m_vertexShader, m_fragmentShader; //File paths, empty if created from a program id
+		std::vector<std::string> m_defines;
+		std::vector<std::string> m_dependencies;
 	};
 }
\ No newline at end of file
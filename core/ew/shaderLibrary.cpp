@@ -0,0 +1,254 @@
+#include "shaderLibrary.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "programCache.h"
+#include "shaderPreprocessor.h"
+#include "glStateCache.h"
+#include "external/glad.h"
+#include <GLFW/glfw3.h>
+
+//From GL_KHR_parallel_shader_compile, which glad was not generated with
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (*PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+namespace ew {
+	/// <summary>
+	/// Checks for the parallel compile extension and lets the driver use as many threads as it likes
+	/// </summary>
+	void ShaderLibrary::initParallelCompile()
+	{
+		m_initialized = true;
+		int numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+		const char* functionName = NULL;
+		for (int i = 0; i < numExtensions && functionName == NULL; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+				functionName = "glMaxShaderCompilerThreadsKHR";
+			else if (strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+				functionName = "glMaxShaderCompilerThreadsARB";
+		}
+		if (functionName == NULL)
+			return;
+		m_parallel = true;
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(functionName);
+		//0xFFFFFFFF lets the implementation pick
+		if (maxShaderCompilerThreads != NULL)
+			maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+
+	void ShaderLibrary::setFallback(const std::string& vertexShader, const std::string& fragmentShader)
+	{
+		m_fallback = Shader(vertexShader, fragmentShader);
+	}
+
+	/// <summary>
+	/// Submits a program for compiling
+	/// </summary>
+	/// <param name="vertexShader">File path to vertex shader</param>
+	/// <param name="fragmentShader">File path to fragment shader</param>
+	/// <param name="defines">Injected into both stages</param>
+	/// <returns>Id for isReady() and get()</returns>
+	int ShaderLibrary::add(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines)
+	{
+		if (!m_initialized)
+			initParallelCompile();
+		m_entries.push_back(Entry());
+		Entry& entry = m_entries.back();
+		entry.vertexShader = vertexShader;
+		entry.fragmentShader = fragmentShader;
+		entry.defines = defines;
+		submit(entry);
+		return (int)m_entries.size() - 1;
+	}
+
+	/// <summary>
+	/// Starts compiling an entry from its files. Nothing here waits on the driver, compile and link status
+	/// are only checked once update() sees the program is complete.
+	/// </summary>
+	/// <returns>True if the program came from the program cache and is already in use</returns>
+	bool ShaderLibrary::submit(Entry& entry)
+	{
+		ShaderSource vertexSource = ew::preprocessShader(entry.vertexShader, entry.defines);
+		ShaderSource fragmentSource = ew::preprocessShader(entry.fragmentShader, entry.defines);
+		std::vector<std::string> dependencies = vertexSource.dependencies;
+		dependencies.insert(dependencies.end(), fragmentSource.dependencies.begin(), fragmentSource.dependencies.end());
+		bool valid = vertexSource.valid && fragmentSource.valid;
+		if (valid) {
+			entry.dependencies = dependencies;
+		}
+		else {
+			//Files after a missing include were never read, so the old list is kept to still reload when they change
+			for (size_t i = 0; i < dependencies.size(); i++)
+			{
+				if (std::find(entry.dependencies.begin(), entry.dependencies.end(), dependencies[i]) == entry.dependencies.end())
+					entry.dependencies.push_back(dependencies[i]);
+			}
+		}
+		if (m_hotReload) {
+			for (size_t i = 0; i < entry.dependencies.size(); i++)
+				m_watcher.watch(entry.dependencies[i]);
+		}
+		//Compiling a half read file would only fail, so the current program stays until the files can be read again
+		if (!valid) {
+			printf("Failed to preprocess %s + %s, keeping the current program\n", entry.vertexShader.c_str(), entry.fragmentShader.c_str());
+			return false;
+		}
+
+		entry.cacheable = ew::isProgramCacheEnabled();
+		if (entry.cacheable) {
+			entry.cacheKey = ew::hashProgramSources(vertexSource.code.c_str(), fragmentSource.code.c_str());
+			unsigned int program = ew::loadCachedProgram(entry.cacheKey);
+			if (program != 0) {
+				replaceShader(entry, program);
+				return true;
+			}
+		}
+
+		const char* source = vertexSource.code.c_str();
+		entry.vertexStage = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(entry.vertexStage, 1, &source, NULL);
+		glCompileShader(entry.vertexStage);
+		source = fragmentSource.code.c_str();
+		entry.fragmentStage = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(entry.fragmentStage, 1, &source, NULL);
+		glCompileShader(entry.fragmentStage);
+
+		//Linking can be queued before compiling finishes, the driver waits for the stages itself
+		entry.program = glCreateProgram();
+		glAttachShader(entry.program, entry.vertexStage);
+		glAttachShader(entry.program, entry.fragmentStage);
+		if (entry.cacheable)
+			glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(entry.program);
+		entry.compiling = true;
+		m_numPending++;
+		return false;
+	}
+
+	/// <summary>
+	/// Without the extension, the status queries below block until the driver is done, so every pending
+	/// program is finished on the first update(). That still lets work between add() and update() overlap
+	/// with drivers that compile lazily.
+	/// </summary>
+	int ShaderLibrary::update()
+	{
+		int numReplaced = 0;
+		if (m_hotReload) {
+			m_changedFiles.clear();
+			m_watcher.poll(m_changedFiles);
+			for (size_t i = 0; i < m_changedFiles.size(); i++)
+			{
+				printf("Reloading shaders using %s\n", m_changedFiles[i].c_str());
+				for (size_t j = 0; j < m_entries.size(); j++)
+				{
+					Entry& entry = m_entries[j];
+					for (size_t d = 0; d < entry.dependencies.size(); d++)
+					{
+						if (entry.dependencies[d] != m_changedFiles[i])
+							continue;
+						//The program being compiled may predate the change, so it is compiled again once done
+						if (entry.compiling)
+							entry.reloadPending = true;
+						else if (submit(entry))
+							numReplaced++;
+						break;
+					}
+				}
+			}
+		}
+		if (m_numPending == 0)
+			return numReplaced;
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			Entry& entry = m_entries[i];
+			if (!entry.compiling)
+				continue;
+			if (m_parallel) {
+				int complete = 0;
+				glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &complete);
+				if (!complete)
+					continue;
+			}
+			finish(entry);
+			if (!entry.failed)
+				numReplaced++;
+		}
+		return numReplaced;
+	}
+
+	void ShaderLibrary::wait(int id)
+	{
+		if (m_entries[id].compiling)
+			finish(m_entries[id]);
+	}
+
+	void ShaderLibrary::enableHotReload()
+	{
+		m_hotReload = true;
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			for (size_t d = 0; d < m_entries[i].dependencies.size(); d++)
+				m_watcher.watch(m_entries[i].dependencies[d]);
+		}
+	}
+
+	/// <summary>
+	/// Makes a linked program the one get() returns, deleting the program it replaces
+	/// </summary>
+	void ShaderLibrary::replaceShader(Entry& entry, unsigned int program)
+	{
+		if (entry.ready) {
+			ew::getGLStateCache().forgetProgram(entry.shader.getProgram());
+			glDeleteProgram(entry.shader.getProgram());
+		}
+		entry.shader = Shader(program);
+		entry.ready = true;
+		entry.failed = false;
+	}
+
+	/// <summary>
+	/// Checks a completed program and reports errors. A program that fails to compile leaves the previous one in use.
+	/// If its files changed while it was compiling, it is submitted again right away.
+	/// </summary>
+	void ShaderLibrary::finish(Entry& entry)
+	{
+		int success = 0;
+		glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			unsigned int stages[2] = { entry.vertexStage, entry.fragmentStage };
+			const std::string* paths[2] = { &entry.vertexShader, &entry.fragmentShader };
+			for (int i = 0; i < 2; i++)
+			{
+				int compiled = 0;
+				glGetShaderiv(stages[i], GL_COMPILE_STATUS, &compiled);
+				if (compiled)
+					continue;
+				glGetShaderInfoLog(stages[i], 512, NULL, infoLog);
+				printf("Failed to compile shader %s: %s", paths[i]->c_str(), infoLog);
+			}
+			glGetProgramInfoLog(entry.program, 512, NULL, infoLog);
+			printf("Failed to link shader program (%s, %s): %s", entry.vertexShader.c_str(), entry.fragmentShader.c_str(), infoLog);
+			glDeleteProgram(entry.program);
+			entry.failed = true;
+		}
+		else {
+			if (entry.cacheable)
+				ew::storeCachedProgram(entry.cacheKey, entry.program);
+			replaceShader(entry, entry.program);
+		}
+		glDeleteShader(entry.vertexStage);
+		glDeleteShader(entry.fragmentStage);
+		entry.program = entry.vertexStage = entry.fragmentStage = 0;
+		entry.compiling = false;
+		m_numPending--;
+		if (entry.reloadPending) {
+			entry.reloadPending = false;
+			submit(entry);
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdint.h>
+#include "shader.h"
+#include "fileWatcher.h"
+
+namespace ew {
+	//Compiles many shader programs without blocking on each one. Programs are all submitted up front,
+	//then update() picks up the ones the driver has finished. With GL_KHR_parallel_shader_compile the driver
+	//compiles on its own threads, so loading textures and meshes overlaps with compiling.
+	//Until a program is ready, get() returns the fallback shader so rendering can start right away.
+	class ShaderLibrary {
+	public:
+		ShaderLibrary() {};
+
+		//Compiled immediately. Used in place of shaders that are not ready or failed to compile.
+		void setFallback(const std::string& vertexShader, const std::string& fragmentShader);
+		//Starts compiling a program and returns its id. Programs found in the program cache are ready immediately.
+		//See preprocessShader for includes and defines.
+		int add(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines = {});
+		//Picks up programs that finished compiling, and with hot reload on, resubmits the ones whose files changed.
+		//Returns how many programs became ready or were replaced this call. Uniform handles and block bindings
+		//of those have to be resolved again.
+		int update();
+		//Blocks until the program is done compiling, like waiting on a future. If its files changed meanwhile,
+		//the recompile that starts afterwards is left to update().
+		void wait(int id);
+		//Watches every file the programs were built from, including includes. When one changes, only the programs
+		//depending on it are recompiled, in the background. The old program stays in use until the new one links.
+		void enableHotReload();
+
+		inline bool isReady(int id)const { return m_entries[id].ready; }
+		//True if the last compile of the program failed
+		inline bool isFailed(int id)const { return m_entries[id].failed; }
+		inline int getNumPending()const { return m_numPending; }
+		inline bool allDone()const { return m_numPending == 0; }
+		//True if the driver compiles in the background
+		inline bool isParallel()const { return m_parallel; }
+		//The program if it is ready, otherwise the fallback. The reference stays valid, but the program it holds
+		//changes when update() finishes a reload.
+		inline const Shader& get(int id)const { return isReady(id) ? m_entries[id].shader : m_fallback; }
+	private:
+		struct Entry {
+			std::string vertexShader;
+			std::string fragmentShader;
+			std::vector<std::string> defines;
+			std::vector<std::string> dependencies; //Every file read by either stage
+			//Program being compiled, replaces shader once it links
+			unsigned int program = 0;
+			unsigned int vertexStage = 0;
+			unsigned int fragmentStage = 0;
+			uint64_t cacheKey = 0;
+			bool cacheable = false;
+			bool compiling = false;
+			bool reloadPending = false; //A file changed while compiling, so finish() submits it again
+			bool ready = false;
+			bool failed = false;
+			Shader shader;
+		};
+		void initParallelCompile();
+		bool submit(Entry& entry);
+		void finish(Entry& entry);
+		void replaceShader(Entry& entry, unsigned int program);
+
+		std::deque<Entry> m_entries; //Deque so add() never moves existing shaders
+		Shader m_fallback;
+		FileWatcher m_watcher;
+		std::vector<std::string> m_changedFiles;
+		int m_numPending = 0;
+		bool m_initialized = false;
+		bool m_parallel = false;
+		bool m_hotReload = false;
+	};
+}
@@ -0,0 +1,108 @@
+#include "shaderPreprocessor.h"
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+namespace ew {
+	static std::string directoryOf(const std::string& filePath) {
+		size_t slash = filePath.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : filePath.substr(0, slash + 1);
+	}
+
+	/// <summary>
+	/// Matches a preprocessor directive, allowing whitespace around the #
+	/// </summary>
+	/// <returns>Position after the directive name, or npos if the line is not that directive</returns>
+	static size_t matchDirective(const std::string& line, const char* directive) {
+		size_t i = line.find_first_not_of(" \t");
+		if (i == std::string::npos || line[i] != '#')
+			return std::string::npos;
+		i = line.find_first_not_of(" \t", i + 1);
+		std::string name(directive);
+		if (i == std::string::npos || line.compare(i, name.size(), name) != 0)
+			return std::string::npos;
+		return i + name.size();
+	}
+
+	/// <summary>
+	/// Reads the path out of #include "path" or #include &lt;path&gt;
+	/// </summary>
+	static bool parseInclude(const std::string& line, std::string& outPath) {
+		size_t i = matchDirective(line, "include");
+		if (i == std::string::npos)
+			return false;
+		i = line.find_first_not_of(" \t", i);
+		if (i == std::string::npos || (line[i] != '"' && line[i] != '<'))
+			return false;
+		size_t end = line.find(line[i] == '"' ? '"' : '>', i + 1);
+		if (end == std::string::npos)
+			return false;
+		outPath = line.substr(i + 1, end - i - 1);
+		return true;
+	}
+
+	/// <summary>
+	/// Appends a file to source.code, recursing into its includes. Files already in the dependency list are skipped,
+	/// which also makes include cycles harmless.
+	/// </summary>
+	/// <param name="defines">Injected after #version. Only passed for the root file.</param>
+	static void appendFile(const std::string& filePath, ShaderSource& source, const std::vector<std::string>* defines) {
+		for (size_t i = 0; i < source.dependencies.size(); i++)
+		{
+			if (source.dependencies[i] == filePath)
+				return;
+		}
+		int fileIndex = (int)source.dependencies.size();
+		source.dependencies.push_back(filePath);
+
+		std::ifstream fstream(filePath);
+		if (!fstream.is_open()) {
+			printf("Failed to load file %s\n", filePath.c_str());
+			source.valid = false;
+			return;
+		}
+		if (defines == NULL)
+			source.code += "#line 1 " + std::to_string(fileIndex) + "\n";
+
+		std::string directory = directoryOf(filePath);
+		std::string line, includePath;
+		int lineNumber = 0;
+		while (std::getline(fstream, line))
+		{
+			lineNumber++;
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (parseInclude(line, includePath)) {
+				appendFile(directory + includePath, source, NULL);
+				source.code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+				continue;
+			}
+			if (matchDirective(line, "version") != std::string::npos) {
+				//Only the root file may set the version
+				if (defines == NULL) {
+					source.code += "\n";
+					continue;
+				}
+				source.code += line + "\n";
+				for (size_t i = 0; i < defines->size(); i++)
+					source.code += "#define " + (*defines)[i] + "\n";
+				source.code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+				continue;
+			}
+			source.code += line + "\n";
+		}
+	}
+
+	/// <summary>
+	/// Loads a shader with its includes resolved
+	/// </summary>
+	/// <param name="filePath">Root shader file, which must start with #version</param>
+	/// <param name="defines">Names, optionally followed by a value, to #define</param>
+	/// <returns></returns>
+	ShaderSource preprocessShader(const std::string& filePath, const std::vector<std::string>& defines)
+	{
+		ShaderSource source;
+		appendFile(filePath, source, &defines);
+		return source;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace ew {
+	//GLSL source after preprocessing, and every file it was built from
+	struct ShaderSource {
+		std::string code;
+		std::vector<std::string> dependencies; //The root file first, then includes in the order they were read
+		bool valid = true; //False if a file could not be read
+	};
+
+	//Reads a shader and resolves #include "file" directives, relative to the including file.
+	//Each file is included at most once. defines are injected right after #version, e.g. "NORMAL_MAP" or "MAX_LIGHTS 16".
+	//#line directives are emitted around includes, so compile errors report the source string number of the file
+	//(its index in dependencies) and the line within it.
+	ShaderSource preprocessShader(const std::string& filePath, const std::vector<std::string>& defines = {});
+}
@@ -0,0 +1,69 @@
+#include "shaderVariants.h"
+
+namespace ew {
+	ShaderVariants::ShaderVariants(ShaderLibrary* library, const std::string& vertexShader, const std::string& fragmentShader,
+		const std::vector<std::string>& features)
+	{
+		create(library, vertexShader, fragmentShader, features);
+	}
+
+	/// <summary>
+	/// Sets up the variants without compiling any of them
+	/// </summary>
+	/// <param name="library">Compiles and owns the variants</param>
+	/// <param name="vertexShader">File path to vertex shader</param>
+	/// <param name="fragmentShader">File path to fragment shader</param>
+	/// <param name="features">Define for each bit of the feature mask, e.g. "NORMAL_MAP"</param>
+	void ShaderVariants::create(ShaderLibrary* library, const std::string& vertexShader, const std::string& fragmentShader,
+		const std::vector<std::string>& features)
+	{
+		m_library = library;
+		m_vertexShader = vertexShader;
+		m_fragmentShader = fragmentShader;
+		m_features = features;
+		m_variants.clear();
+		m_lastReady = -1;
+	}
+
+	/// <summary>
+	/// Looks up a variant, submitting it to the library the first time
+	/// </summary>
+	/// <returns>ShaderLibrary id of the variant</returns>
+	int ShaderVariants::variantId(uint32_t featureMask)
+	{
+		featureMask &= getAllFeatures();
+		auto it = m_variants.find(featureMask);
+		if (it != m_variants.end())
+			return it->second;
+		std::vector<std::string> defines;
+		for (size_t i = 0; i < m_features.size(); i++)
+		{
+			if (featureMask & (1u << i))
+				defines.push_back(m_features[i]);
+		}
+		int id = m_library->add(m_vertexShader, m_fragmentShader, defines);
+		m_variants[featureMask] = id;
+		return id;
+	}
+
+	void ShaderVariants::prepare(uint32_t featureMask)
+	{
+		variantId(featureMask);
+	}
+
+	const Shader& ShaderVariants::get(uint32_t featureMask)
+	{
+		int id = variantId(featureMask);
+		if (m_library->isReady(id)) {
+			m_lastReady = id;
+			return m_library->get(id);
+		}
+		return m_library->get(m_lastReady >= 0 ? m_lastReady : id);
+	}
+
+	bool ShaderVariants::isReady(uint32_t featureMask) const
+	{
+		auto it = m_variants.find(featureMask & getAllFeatures());
+		return it != m_variants.end() && m_library->isReady(it->second);
+	}
+}
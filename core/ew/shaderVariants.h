@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "shader.h"
+#include "shaderLibrary.h"
+
+namespace ew {
+	//Compile time permutations of one shader. Each feature is a #define, and a variant is the set of features
+	//in a bitmask, bit i being features[i]. Features a material doesn't use are compiled out instead of being
+	//branched around at runtime. Variants are compiled by a ShaderLibrary the first time they are asked for.
+	class ShaderVariants {
+	public:
+		ShaderVariants() {};
+		ShaderVariants(ShaderLibrary* library, const std::string& vertexShader, const std::string& fragmentShader,
+			const std::vector<std::string>& features);
+		void create(ShaderLibrary* library, const std::string& vertexShader, const std::string& fragmentShader,
+			const std::vector<std::string>& features);
+
+		//Starts compiling a variant ahead of time, so the first get() doesn't have to wait for it
+		void prepare(uint32_t featureMask);
+		//The variant for featureMask. While it compiles, the last variant that was ready is returned instead,
+		//or the library's fallback if there is none yet.
+		const Shader& get(uint32_t featureMask);
+		bool isReady(uint32_t featureMask)const;
+		inline int getNumVariants()const { return (int)m_variants.size(); }
+		inline uint32_t getAllFeatures()const { return m_features.size() >= 32 ? 0xFFFFFFFF : (1u << m_features.size()) - 1; }
+	private:
+		int variantId(uint32_t featureMask);
+
+		ShaderLibrary* m_library = nullptr;
+		std::string m_vertexShader;
+		std::string m_fragmentShader;
+		std::vector<std::string> m_features;
+		std::unordered_map<uint32_t, int> m_variants; //Feature mask to ShaderLibrary id
+		int m_lastReady = -1;
+	};
+}
@@ -0,0 +1,160 @@
+#include "streamBuffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <utility>
+#include "external/glad.h"
+
+namespace ew {
+	static const GLbitfield STREAM_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	static inline size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	StreamBuffer::StreamBuffer(size_t bytesPerFrame, int framesInFlight)
+	{
+		create(bytesPerFrame, framesInFlight);
+	}
+
+	StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	/// <summary>
+	/// Takes over other's buffer, mapping and fences, leaving other empty
+	/// </summary>
+	StreamBuffer& StreamBuffer::operator=(StreamBuffer&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		destroy();
+		m_buffer = other.m_buffer;
+		m_mapped = other.m_mapped;
+		m_regionSize = other.m_regionSize;
+		m_numRegions = other.m_numRegions;
+		m_region = other.m_region;
+		m_used = other.m_used;
+		m_fences = std::move(other.m_fences);
+		m_numFenceWaits = other.m_numFenceWaits;
+		m_fenceWaitTime = other.m_fenceWaitTime;
+		other.m_buffer = 0;
+		other.m_mapped = nullptr;
+		other.m_fences.clear();
+		other.m_used = 0;
+		return *this;
+	}
+
+	void StreamBuffer::destroy()
+	{
+		for (size_t i = 0; i < m_fences.size(); i++)
+		{
+			if (m_fences[i] != nullptr)
+				glDeleteSync((GLsync)m_fences[i]);
+		}
+		m_fences.clear();
+		if (m_buffer != 0) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			//GL keeps the storage alive until draws already queued are done with it
+			glDeleteBuffers(1, &m_buffer);
+			m_buffer = 0;
+		}
+		m_mapped = nullptr;
+	}
+
+	/// <summary>
+	/// Allocates immutable storage for every region and maps it once for the lifetime of the buffer
+	/// </summary>
+	/// <param name="bytesPerFrame">Size of each region, including padding for alignment</param>
+	/// <param name="framesInFlight">Number of regions in the ring</param>
+	void StreamBuffer::create(size_t bytesPerFrame, int framesInFlight)
+	{
+		destroy();
+		m_regionSize = alignUp(bytesPerFrame > 0 ? bytesPerFrame : 1, 256);
+		m_numRegions = framesInFlight > 1 ? framesInFlight : 2;
+		m_region = 0;
+		m_used = 0;
+		m_fences.assign(m_numRegions, nullptr);
+
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, m_regionSize * m_numRegions, NULL, STREAM_MAP_FLAGS);
+		m_mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_regionSize * m_numRegions, STREAM_MAP_FLAGS);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		if (m_mapped == nullptr)
+			printf("StreamBuffer: failed to map %zu bytes\n", m_regionSize * m_numRegions);
+	}
+
+	/// <summary>
+	/// The fence for the region just finished is inserted after every command issued so far,
+	/// so it signals once the GPU is done with everything that could read that region.
+	/// </summary>
+	void StreamBuffer::beginFrame()
+	{
+		if (m_mapped == nullptr)
+			return;
+		if (m_fences[m_region] != nullptr)
+			glDeleteSync((GLsync)m_fences[m_region]);
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_region = (m_region + 1) % m_numRegions;
+		m_used = 0;
+
+		GLsync fence = (GLsync)m_fences[m_region];
+		if (fence == nullptr)
+			return;
+		//Polling with a timeout of 0 doesn't block, and is the common case
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			m_numFenceWaits++;
+			auto start = std::chrono::high_resolution_clock::now();
+			//Flush so the fence is guaranteed to reach the GPU, then wait in 1 ms steps
+			GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			do {
+				status = glClientWaitSync(fence, flags, 1000000);
+				flags = 0;
+			} while (status == GL_TIMEOUT_EXPIRED);
+			m_fenceWaitTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		glDeleteSync(fence);
+		m_fences[m_region] = nullptr;
+	}
+
+	size_t StreamBuffer::alignedOffset(size_t alignment) const
+	{
+		//Aligned relative to the whole buffer, since that's the offset it gets bound at
+		size_t regionStart = m_region * m_regionSize;
+		return alignUp(regionStart + m_used, alignment > 0 ? alignment : 1) - regionStart;
+	}
+
+	bool StreamBuffer::canAllocate(size_t size, size_t alignment) const
+	{
+		return m_mapped != nullptr && alignedOffset(alignment) + size <= m_regionSize;
+	}
+
+	StreamRange StreamBuffer::allocate(size_t size, size_t alignment)
+	{
+		StreamRange range;
+		size_t regionStart = m_region * m_regionSize;
+		size_t offset = alignedOffset(alignment);
+		if (m_mapped == nullptr || offset + size > m_regionSize) {
+			printf("StreamBuffer: out of space, %zu of %zu bytes used this frame\n", m_used, m_regionSize);
+			return range;
+		}
+		m_used = offset + size;
+		range.offset = regionStart + offset;
+		range.size = size;
+		range.data = m_mapped + range.offset;
+		return range;
+	}
+
+	StreamRange StreamBuffer::write(const void* data, size_t size, size_t alignment)
+	{
+		StreamRange range = allocate(size, alignment);
+		if (range.data != nullptr)
+			memcpy(range.data, data, size);
+		return range;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+namespace ew {
+	//Part of a StreamBuffer written this frame
+	struct StreamRange {
+		size_t offset = 0; //From the start of the buffer, for binding
+		size_t size = 0; //0 if the allocation didn't fit
+		void* data = nullptr; //Write only, mapped GPU memory
+	};
+
+	//Ring of per frame regions in one persistently mapped buffer (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT).
+	//Data is written straight into GPU visible memory, with no glBufferSubData copy and no orphaning.
+	//Each region gets a fence when the frame that wrote it ends, and is only reused once the fence has signaled.
+	//No stall: beginFrame() never waits as long as the GPU is fewer than framesInFlight frames behind,
+	//which drivers already ensure by limiting queued frames. getNumFenceWaits() shows if that ever fails to hold.
+	//Owns the buffer, its mapping and its fences, so it can be moved but not copied.
+	class StreamBuffer {
+	public:
+		StreamBuffer() {};
+		StreamBuffer(size_t bytesPerFrame, int framesInFlight = 3);
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+		StreamBuffer(StreamBuffer&& other) noexcept;
+		StreamBuffer& operator=(StreamBuffer&& other) noexcept;
+		~StreamBuffer() { destroy(); }
+		void create(size_t bytesPerFrame, int framesInFlight = 3);
+
+		//Fences the region written since the last call and moves on to the next one. Call once per frame,
+		//before writing, after every draw that reads last frame's data has been issued.
+		void beginFrame();
+		//Space in this frame's region, starting on a multiple of alignment
+		StreamRange allocate(size_t size, size_t alignment = 16);
+		//True if allocate() would fit in what is left of this frame's region
+		bool canAllocate(size_t size, size_t alignment = 16)const;
+		//allocate() and copies data into it
+		StreamRange write(const void* data, size_t size, size_t alignment = 16);
+
+		inline unsigned int getBuffer()const { return m_buffer; }
+		inline size_t getRegionSize()const { return m_regionSize; }
+		//How often beginFrame() found the GPU still reading the next region, and the total time it waited
+		inline int getNumFenceWaits()const { return m_numFenceWaits; }
+		inline double getFenceWaitTime()const { return m_fenceWaitTime; }
+	private:
+		void destroy();
+		//Offset of the next allocation from the start of this frame's region
+		size_t alignedOffset(size_t alignment)const;
+
+		unsigned int m_buffer = 0;
+		unsigned char* m_mapped = nullptr;
+		size_t m_regionSize = 0;
+		int m_numRegions = 0;
+		int m_region = 0;
+		size_t m_used = 0;
+		std::vector<void*> m_fences; //GLsync per region, null if the GPU has nothing queued that reads it
+		int m_numFenceWaits = 0;
+		double m_fenceWaitTime = 0.0;
+	};
+}
@@ -1,13 +1,18 @@
 #pragma once
 #include "ewMath/ewMath.h"
 #include "ewMath/transformations.h"
+#include "ewMath/quat.h"
 namespace ew {
 	struct Transform {
 		ew::Vec3 position = ew::Vec3(0.0f, 0.0f, 0.0f);
 		ew::Vec3 rotation = ew::Vec3(0.0f, 0.0f, 0.0f); //Euler angles (Degrees)
 		ew::Vec3 scale = ew::Vec3(1.0f, 1.0f, 1.0f);
+		ew::Quat orientation; //Replaces rotation when useQuaternion is set. Must be unit length.
+		bool useQuaternion = false;
 
 		ew::Mat4 getModelMatrix() const {
+			if (useQuaternion)
+				return ew::TRS(position, orientation, scale);
 			return ew::Translate(position)
 				* ew::RotateY(ew::Radians(rotation.y))
 				* ew::RotateX(ew::Radians(rotation.x))
@@ -15,4 +20,88 @@ namespace ew {
 				* ew::Scale(scale);
 		}
 	};
+
+	//Transform that only rebuilds its model matrix after it has been changed through a setter
+	class CachedTransform {
+	public:
+		CachedTransform() {};
+		CachedTransform(const Transform& transform) :m_transform(transform) {};
+
+		inline const ew::Vec3& getPosition()const { return m_transform.position; }
+		inline const ew::Vec3& getRotation()const { return m_transform.rotation; }
+		inline const ew::Vec3& getScale()const { return m_transform.scale; }
+		inline const ew::Quat& getOrientation()const { return m_transform.orientation; }
+		inline const Transform& getTransform()const { return m_transform; }
+
+		//Setting a value equal to the current one is a no-op, so callers can set every frame without invalidating derived data
+		inline void setPosition(const ew::Vec3& position) {
+			if (equalVec3(m_transform.position, position))
+				return;
+			m_transform.position = position;
+			markDirty();
+		}
+		inline void setRotation(const ew::Vec3& rotation) {
+			if (equalVec3(m_transform.rotation, rotation))
+				return;
+			m_transform.rotation = rotation;
+			markDirty();
+		}
+		//Switches the transform to quaternion rotation. Must be unit length.
+		inline void setOrientation(const ew::Quat& orientation) {
+			if (m_transform.useQuaternion && equalQuat(m_transform.orientation, orientation))
+				return;
+			m_transform.orientation = orientation;
+			m_transform.useQuaternion = true;
+			markDirty();
+		}
+		inline void setScale(const ew::Vec3& scale) {
+			if (equalVec3(m_transform.scale, scale))
+				return;
+			m_transform.scale = scale;
+			markDirty();
+		}
+		inline void setTransform(const Transform& transform) {
+			if (equalVec3(m_transform.position, transform.position) && equalVec3(m_transform.rotation, transform.rotation)
+				&& equalVec3(m_transform.scale, transform.scale) && equalQuat(m_transform.orientation, transform.orientation)
+				&& m_transform.useQuaternion == transform.useQuaternion)
+				return;
+			m_transform = transform;
+			markDirty();
+		}
+
+		//Incremented on every change. Store it alongside derived data (uniforms, bounds) to know when that data is stale.
+		inline unsigned int getVersion()const { return m_version; }
+		inline bool isDirty()const { return m_dirty; }
+
+		const ew::Mat4& getModelMatrix()const {
+			if (m_dirty) {
+				m_modelMatrix = m_transform.getModelMatrix();
+				m_dirty = false;
+			}
+			return m_modelMatrix;
+		}
+		//Inverse transpose of the model matrix, for transforming normals
+		const ew::Mat4& getNormalMatrix()const {
+			if (m_normalDirty) {
+				m_normalMatrix = ew::NormalMatrix(getModelMatrix());
+				m_normalDirty = false;
+			}
+			return m_normalMatrix;
+		}
+	private:
+		inline void markDirty() { m_dirty = true; m_normalDirty = true; m_version++; }
+		static inline bool equalVec3(const ew::Vec3& a, const ew::Vec3& b) {
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+		static inline bool equalQuat(const ew::Quat& a, const ew::Quat& b) {
+			return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+		}
+
+		Transform m_transform;
+		mutable ew::Mat4 m_modelMatrix;
+		mutable ew::Mat4 m_normalMatrix;
+		mutable bool m_dirty = true;
+		mutable bool m_normalDirty = true;
+		unsigned int m_version = 0;
+	};
 }
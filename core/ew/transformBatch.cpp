@@ -0,0 +1,207 @@
+#include "transformBatch.h"
+#include <thread>
+#include <functional>
+#if defined(EW_MATH_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace ew {
+	//Cody-Waite split of PI/2 and minimax coefficients for sin/cos on [-PI/4, PI/4] (Cephes)
+	static const float TWO_OVER_PI = 0.636619772367581f;
+	static const float PIO2_1 = 1.5703125f;
+	static const float PIO2_2 = 4.837512969970703125e-4f;
+	static const float PIO2_3 = 7.54978995489188216e-8f;
+	static const float SIN_0 = -1.6666654611e-1f;
+	static const float SIN_1 = 8.3321608736e-3f;
+	static const float SIN_2 = -1.9515295891e-4f;
+	static const float COS_0 = 4.166664568298827e-2f;
+	static const float COS_1 = -1.388731625493765e-3f;
+	static const float COS_2 = 2.443315711809948e-5f;
+
+	//Transforms are processed in blocks so the sin/cos scratch stays on the stack
+	static const size_t BLOCK_SIZE = 64;
+	//Below this many transforms per thread, spawning threads costs more than it saves
+	static const size_t MIN_TRANSFORMS_PER_THREAD = 2048;
+
+	void TransformStream::resize(size_t count)
+	{
+		positionX.resize(count); positionY.resize(count); positionZ.resize(count);
+		rotationX.resize(count); rotationY.resize(count); rotationZ.resize(count);
+		orientationX.resize(count); orientationY.resize(count); orientationZ.resize(count); orientationW.resize(count);
+		useQuaternion.resize(count);
+		scaleX.resize(count); scaleY.resize(count); scaleZ.resize(count);
+	}
+
+	void TransformStream::load(const Transform* transforms, size_t count)
+	{
+		resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Transform& t = transforms[i];
+			positionX[i] = t.position.x; positionY[i] = t.position.y; positionZ[i] = t.position.z;
+			ew::Vec3 rad = t.useQuaternion ? ew::Vec3(0.0f) : t.rotation * ew::DEG2RAD;
+			rotationX[i] = rad.x;
+			rotationY[i] = rad.y;
+			rotationZ[i] = rad.z;
+			orientationX[i] = t.orientation.x; orientationY[i] = t.orientation.y;
+			orientationZ[i] = t.orientation.z; orientationW[i] = t.orientation.w;
+			useQuaternion[i] = t.useQuaternion;
+			scaleX[i] = t.scale.x; scaleY[i] = t.scale.y; scaleZ[i] = t.scale.z;
+		}
+	}
+
+	/// <summary>
+	/// Branchless sin/cos of a single value, using the same reduction and polynomials as the SIMD path
+	/// </summary>
+	static inline void sinCosScalar(float x, float* outSin, float* outCos) {
+		int j = (int)nearbyintf(x * TWO_OVER_PI);
+		float fj = (float)j;
+		float y = ((x - fj * PIO2_1) - fj * PIO2_2) - fj * PIO2_3;
+		float z = y * y;
+		float s = y + y * z * (SIN_0 + z * (SIN_1 + z * SIN_2));
+		float c = 1.0f - 0.5f * z + z * z * (COS_0 + z * (COS_1 + z * COS_2));
+		//Quadrant j: odd quadrants swap sin/cos, bit 2 flips sign
+		float sinV = (j & 1) ? c : s;
+		float cosV = (j & 1) ? s : c;
+		*outSin = (j & 2) ? -sinV : sinV;
+		*outCos = ((j + 1) & 2) ? -cosV : cosV;
+	}
+
+	/// <summary>
+	/// Computes sin and cos for each element of x.
+	/// </summary>
+	/// <param name="x">Angles in radians</param>
+	/// <param name="outSin">Array of count floats to receive sin(x)</param>
+	/// <param name="outCos">Array of count floats to receive cos(x)</param>
+	/// <param name="count">Number of elements</param>
+	void SinCos(const float* x, float* outSin, float* outCos, size_t count)
+	{
+		size_t i = 0;
+#if defined(EW_MATH_SSE)
+		const __m128 twoOverPi = _mm_set1_ps(TWO_OVER_PI);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_loadu_ps(x + i);
+			__m128i j = _mm_cvtps_epi32(_mm_mul_ps(v, twoOverPi));
+			__m128 fj = _mm_cvtepi32_ps(j);
+			__m128 y = _mm_sub_ps(v, _mm_mul_ps(fj, _mm_set1_ps(PIO2_1)));
+			y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(PIO2_2)));
+			y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(PIO2_3)));
+			__m128 z = _mm_mul_ps(y, y);
+
+			__m128 s = _mm_add_ps(_mm_set1_ps(SIN_1), _mm_mul_ps(z, _mm_set1_ps(SIN_2)));
+			s = _mm_add_ps(_mm_set1_ps(SIN_0), _mm_mul_ps(z, s));
+			s = _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(y, z), s));
+
+			__m128 c = _mm_add_ps(_mm_set1_ps(COS_1), _mm_mul_ps(z, _mm_set1_ps(COS_2)));
+			c = _mm_add_ps(_mm_set1_ps(COS_0), _mm_mul_ps(z, c));
+			c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), c));
+
+			__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+			__m128 sinV = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+			__m128 cosV = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+			__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, two), 30));
+			__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one), two), 30));
+			_mm_storeu_ps(outSin + i, _mm_xor_ps(sinV, sinSign));
+			_mm_storeu_ps(outCos + i, _mm_xor_ps(cosV, cosSign));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			sinCosScalar(x[i], outSin + i, outCos + i);
+		}
+	}
+
+	/// <summary>
+	/// Closed form TRS for transforms [first, last) of the stream
+	/// </summary>
+	static void computeModelMatrixRange(const TransformStream& stream, ew::Mat4* outModels, size_t first, size_t last) {
+		float sx[BLOCK_SIZE], cx[BLOCK_SIZE];
+		float sy[BLOCK_SIZE], cy[BLOCK_SIZE];
+		float sz[BLOCK_SIZE], cz[BLOCK_SIZE];
+		for (size_t start = first; start < last; start += BLOCK_SIZE)
+		{
+			size_t count = last - start < BLOCK_SIZE ? last - start : BLOCK_SIZE;
+			SinCos(&stream.rotationX[start], sx, cx, count);
+			SinCos(&stream.rotationY[start], sy, cy, count);
+			SinCos(&stream.rotationZ[start], sz, cz, count);
+			for (size_t k = 0; k < count; k++)
+			{
+				size_t i = start + k;
+				float scX = stream.scaleX[i], scY = stream.scaleY[i], scZ = stream.scaleZ[i];
+				ew::Mat4& m = outModels[i];
+				if (stream.useQuaternion[i]) {
+					//Same expressions as ew::TRS, so the result matches Transform::getModelMatrix() exactly
+					float qx = stream.orientationX[i], qy = stream.orientationY[i];
+					float qz = stream.orientationZ[i], qw = stream.orientationW[i];
+					float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+					float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+					float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+					m[0][0] = (1.0f - 2.0f * (yy + zz)) * scX;
+					m[0][1] = 2.0f * (xy + wz) * scX;
+					m[0][2] = 2.0f * (xz - wy) * scX;
+					m[1][0] = 2.0f * (xy - wz) * scY;
+					m[1][1] = (1.0f - 2.0f * (xx + zz)) * scY;
+					m[1][2] = 2.0f * (yz + wx) * scY;
+					m[2][0] = 2.0f * (xz + wy) * scZ;
+					m[2][1] = 2.0f * (yz - wx) * scZ;
+					m[2][2] = (1.0f - 2.0f * (xx + yy)) * scZ;
+				}
+				else {
+					//Columns of RotateY * RotateX * RotateZ, each scaled by its scale axis
+					m[0][0] = (cy[k] * cz[k] + sy[k] * sx[k] * sz[k]) * scX;
+					m[0][1] = (cx[k] * sz[k]) * scX;
+					m[0][2] = (cy[k] * sx[k] * sz[k] - sy[k] * cz[k]) * scX;
+					m[1][0] = (sy[k] * sx[k] * cz[k] - cy[k] * sz[k]) * scY;
+					m[1][1] = (cx[k] * cz[k]) * scY;
+					m[1][2] = (sy[k] * sz[k] + cy[k] * sx[k] * cz[k]) * scY;
+					m[2][0] = (sy[k] * cx[k]) * scZ;
+					m[2][1] = -sx[k] * scZ;
+					m[2][2] = (cy[k] * cx[k]) * scZ;
+				}
+				m[0][3] = 0.0f;
+				m[1][3] = 0.0f;
+				m[2][3] = 0.0f;
+				m[3][0] = stream.positionX[i];
+				m[3][1] = stream.positionY[i];
+				m[3][2] = stream.positionZ[i];
+				m[3][3] = 1.0f;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Computes model matrices for every transform in the stream.
+	/// </summary>
+	/// <param name="stream">Transforms to evaluate</param>
+	/// <param name="outModels">Array of stream.size() matrices to fill</param>
+	/// <param name="threadCount">Max number of threads to use, including the calling thread</param>
+	void computeModelMatrices(const TransformStream& stream, ew::Mat4* outModels, int threadCount)
+	{
+		size_t count = stream.size();
+		size_t maxThreads = count / MIN_TRANSFORMS_PER_THREAD;
+		size_t numThreads = threadCount > 1 ? (size_t)threadCount : 1;
+		if (numThreads > maxThreads)
+			numThreads = maxThreads > 0 ? maxThreads : 1;
+
+		if (numThreads == 1) {
+			computeModelMatrixRange(stream, outModels, 0, count);
+			return;
+		}
+		size_t chunk = (count + numThreads - 1) / numThreads;
+		std::vector<std::thread> workers;
+		workers.reserve(numThreads - 1);
+		for (size_t t = 1; t < numThreads; t++)
+		{
+			size_t first = t * chunk;
+			size_t last = first + chunk < count ? first + chunk : count;
+			workers.emplace_back(computeModelMatrixRange, std::cref(stream), outModels, first, last);
+		}
+		//Calling thread takes the first chunk
+		computeModelMatrixRange(stream, outModels, 0, chunk);
+		for (auto& worker : workers)
+			worker.join();
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include "transform.h"
+
+namespace ew {
+	//Structure of arrays copy of a span of transforms. Rotation is stored in radians.
+	//Transforms with useQuaternion keep their orientation instead, and their rotation is left at 0.
+	struct TransformStream {
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ;
+		std::vector<float> orientationX, orientationY, orientationZ, orientationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+		std::vector<unsigned char> useQuaternion;
+
+		inline size_t size()const { return positionX.size(); }
+		void resize(size_t count);
+		//Copies transforms into the stream, converting rotation to radians
+		void load(const Transform* transforms, size_t count);
+	};
+
+	//Computes sin and cos of every element of x. Max error is ~1e-7 for |x| < 8192
+	void SinCos(const float* x, float* outSin, float* outCos, size_t count);
+
+	//Writes Translate * RotateY * RotateX * RotateZ * Scale for every transform in the stream,
+	//or ew::TRS for the ones with useQuaternion. Either way it matches Transform::getModelMatrix().
+	//Work is split across threadCount threads when the stream is large enough.
+	void computeModelMatrices(const TransformStream& stream, ew::Mat4* outModels, int threadCount = 1);
+}
@@ -0,0 +1,56 @@
+#include "uniformBuffer.h"
+#include "external/glad.h"
+
+namespace ew {
+	static inline size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	UniformBuffer::UniformBuffer(size_t bytesPerFrame, int blocksPerFrame, int framesInFlight)
+	{
+		create(bytesPerFrame, blocksPerFrame, framesInFlight);
+	}
+
+	/// <summary>
+	/// Allocates the GPU buffer. Each frame gets its own region, so writing this frame's blocks
+	/// doesn't have to wait on draws from previous frames that are still reading theirs.
+	/// </summary>
+	/// <param name="bytesPerFrame">Total size of the blocks pushed each frame</param>
+	/// <param name="blocksPerFrame">Max number of blocks pushed each frame</param>
+	/// <param name="framesInFlight">Number of regions in the ring</param>
+	void UniformBuffer::create(size_t bytesPerFrame, int blocksPerFrame, int framesInFlight)
+	{
+		int alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		m_alignment = (size_t)alignment;
+		//Every block starts on an aligned offset, so each one may add up to alignment - 1 bytes of padding
+		m_stream.create(alignUp(bytesPerFrame + blocksPerFrame * (m_alignment - 1), m_alignment), framesInFlight);
+	}
+
+	void UniformBuffer::beginFrame()
+	{
+		m_stream.beginFrame();
+	}
+
+	/// <summary>
+	/// Copies a block into this frame's region
+	/// </summary>
+	/// <param name="data">Block in std140 layout</param>
+	/// <param name="size">Size in bytes</param>
+	/// <returns>Where the block is in the buffer, for bind()</returns>
+	UniformRange UniformBuffer::push(const void* data, size_t size)
+	{
+		UniformRange range;
+		StreamRange streamRange = m_stream.write(data, size, m_alignment);
+		range.offset = streamRange.offset;
+		range.size = streamRange.size;
+		return range;
+	}
+
+	void UniformBuffer::bind(unsigned int binding, const UniformRange& range) const
+	{
+		if (range.size == 0)
+			return;
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_stream.getBuffer(), range.offset, range.size);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stddef.h>
+#include "ewMath/ewMath.h"
+#include "streamBuffer.h"
+
+namespace ew {
+	//Binding points for the blocks below. Shaders bind them by name with Shader::bindUniformBlock.
+	const unsigned int UNIFORM_BINDING_CAMERA = 0;
+	const unsigned int UNIFORM_BINDING_FRAME = 1;
+	const unsigned int UNIFORM_BINDING_MATERIAL = 2;
+	const unsigned int UNIFORM_BINDING_CLUSTERS = 3;
+
+	//CPU copies of std140 blocks. vec3 members take 16 bytes in std140, hence the padding floats.
+
+	//layout(std140) uniform CameraBlock, one per render pass
+	struct CameraUniforms {
+		ew::Mat4 viewProjection;
+		ew::Mat4 view;
+		ew::Mat4 projection;
+		ew::Vec3 position;
+		float pad0;
+	};
+
+	//layout(std140) uniform FrameBlock, once per frame. The lights themselves are in a LightBuffer.
+	struct FrameUniforms {
+		int numLights;
+		float time;
+		float pad0[2];
+		ew::Vec3 ambientLight; //LightBuffer::getTotalColor(), ambient light doesn't fall off with distance
+		float pad1;
+	};
+
+	//layout(std140) uniform MaterialBlock, one per material
+	struct MaterialUniforms {
+		float ambientK;
+		float diffuseK;
+		float specular;
+		float shininess;
+	};
+
+	static_assert(offsetof(CameraUniforms, position) == 192 && sizeof(CameraUniforms) == 208, "CameraUniforms must match std140");
+	static_assert(offsetof(FrameUniforms, ambientLight) == 16 && sizeof(FrameUniforms) == 32, "FrameUniforms must match std140");
+	static_assert(sizeof(MaterialUniforms) == 16, "MaterialUniforms must match std140");
+
+	//Part of a UniformBuffer holding one block
+	struct UniformRange {
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	//Ring buffered uniform buffer object. Each frame, blocks are written straight into a persistently mapped
+	//region the GPU is no longer reading from (see StreamBuffer), then bound by range.
+	class UniformBuffer {
+	public:
+		UniformBuffer() {};
+		//bytesPerFrame is the total size of at most blocksPerFrame blocks pushed in one frame
+		UniformBuffer(size_t bytesPerFrame, int blocksPerFrame, int framesInFlight = 3);
+		void create(size_t bytesPerFrame, int blocksPerFrame, int framesInFlight = 3);
+
+		//Moves to the next region of the ring and discards last frame's blocks. Waits if the GPU is still
+		//reading that region, which getNumFenceWaits() counts.
+		void beginFrame();
+		//Copies a block into this frame's region. The mapping is coherent, so draws issued afterwards see it
+		//without a separate upload step.
+		UniformRange push(const void* data, size_t size);
+		template<typename T>
+		inline UniformRange push(const T& block) { return push(&block, sizeof(T)); }
+		void bind(unsigned int binding, const UniformRange& range)const;
+		inline unsigned int getBuffer()const { return m_stream.getBuffer(); }
+		inline int getNumFenceWaits()const { return m_stream.getNumFenceWaits(); }
+	private:
+		StreamBuffer m_stream;
+		size_t m_alignment = 256;
+	};
+}